@@ -0,0 +1,238 @@
+#pragma once
+
+#include "graph.h"
+#include "parallel.h"
+#include "router.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+  // Полная таблица кратчайших путей между всеми парами вершин.
+  // Строится блочным алгоритмом Флойда-Уоршелла: независимые блоки каждой фазы
+  // обрабатываются параллельно, после чего запрос маршрута - O(длина маршрута).
+  // Таблица хранит веса в типе StoredWeight и 32-битные рёбра-предшественники: с float
+  // ячейка занимает 8 байт. Если StoredWeight грубее Weight, вес маршрута пересчитывается
+  // по его рёбрам, а сам маршрут оптимален с точностью до погрешности StoredWeight.
+  template<typename Weight, typename StoredWeight = Weight>
+  class AllPairsRouter {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64;
+
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    // Построенные таблицы по строкам: элемент (from, to) лежит в позиции from * vertex_count + to
+    struct Data {
+      std::vector<StoredWeight> weights;
+      std::vector<PrevEdgeId> prev_edges;
+    };
+
+    explicit AllPairsRouter(const Graph &graph, size_t threads_count = 0, size_t block_size = DEFAULT_BLOCK_SIZE);
+
+    // Восстанавливает ранее построенные таблицы без пересчёта
+    AllPairsRouter(const Graph &graph, Data data);
+
+    Data GetData() const {
+      return {weights_, prev_edges_};
+    }
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    // Вес кратчайшего пути. Рёбра восстанавливаются, только если StoredWeight грубее Weight
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+
+    const Graph &GetGraph() const {
+      return graph_;
+    }
+
+  private:
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr StoredWeight INFINITE_WEIGHT = std::numeric_limits<StoredWeight>::has_infinity
+                                                    ? std::numeric_limits<StoredWeight>::infinity()
+                                                    : std::numeric_limits<StoredWeight>::max() / 2;
+    static constexpr bool IS_EXACT = std::is_same_v<Weight, StoredWeight>;
+
+    void InitializeMatrices();
+
+    std::vector<EdgeId> ReconstructEdges(VertexId from, VertexId to) const;
+
+    // Вес в точности Weight: сумма весов рёбер в порядке следования, как при поиске Дейкстры
+    Weight SumEdgeWeights(const std::vector<EdgeId> &edges) const;
+
+    // Релаксирует блок (row_block, column_block) через вершины блока through_block
+    void RelaxBlock(size_t row_block, size_t column_block, size_t through_block);
+
+    const Graph &graph_;
+    size_t vertex_count_;
+    size_t block_size_;
+    // Матрицы хранятся по строкам: элемент (from, to) лежит в позиции from * vertex_count_ + to
+    std::vector<StoredWeight> weights_;
+    std::vector<PrevEdgeId> prev_edges_;
+  };
+
+  template<typename Weight, typename StoredWeight>
+  AllPairsRouter<Weight, StoredWeight>::AllPairsRouter(const Graph &graph, size_t threads_count, size_t block_size)
+      : graph_(graph), vertex_count_(graph.GetVertexCount()), block_size_(std::max<size_t>(block_size, 1)),
+        weights_(vertex_count_ * vertex_count_, INFINITE_WEIGHT),
+        prev_edges_(vertex_count_ * vertex_count_, NO_PREV_EDGE) {
+    CheckPrevEdgeIdCapacity(graph.GetEdgeCount());
+    InitializeMatrices();
+
+    const size_t blocks_count = (vertex_count_ + block_size_ - 1) / block_size_;
+    for (size_t through_block = 0; through_block < blocks_count; ++through_block) {
+      // Фаза 1: диагональный блок зависит только от самого себя
+      RelaxBlock(through_block, through_block, through_block);
+
+      // Фаза 2: блоки строки и столбца диагонального блока
+      parallel::ForEachIndex(2 * blocks_count, threads_count, [&](size_t index) {
+        const size_t other_block = index / 2;
+        if (other_block == through_block) {
+          return;
+        }
+        if (index % 2 == 0) {
+          RelaxBlock(through_block, other_block, through_block);
+        } else {
+          RelaxBlock(other_block, through_block, through_block);
+        }
+      });
+
+      // Фаза 3: остальные блоки зависят только от блоков фазы 2
+      parallel::ForEachIndex(blocks_count * blocks_count, threads_count, [&](size_t index) {
+        const size_t row_block = index / blocks_count;
+        const size_t column_block = index % blocks_count;
+        if (row_block != through_block && column_block != through_block) {
+          RelaxBlock(row_block, column_block, through_block);
+        }
+      });
+    }
+  }
+
+  template<typename Weight, typename StoredWeight>
+  AllPairsRouter<Weight, StoredWeight>::AllPairsRouter(const Graph &graph, Data data)
+      : graph_(graph), vertex_count_(graph.GetVertexCount()), block_size_(DEFAULT_BLOCK_SIZE),
+        weights_(std::move(data.weights)), prev_edges_(std::move(data.prev_edges)) {
+    if (weights_.size() != vertex_count_ * vertex_count_ || prev_edges_.size() != weights_.size()) {
+      throw std::invalid_argument("All pairs tables do not match the graph");
+    }
+    const size_t edge_count = graph_.GetEdgeCount();
+    if (std::any_of(prev_edges_.begin(), prev_edges_.end(), [edge_count](PrevEdgeId edge_id) {
+      return edge_id != NO_PREV_EDGE && edge_id >= edge_count;
+    })) {
+      throw std::invalid_argument("Edge id is out of range");
+    }
+  }
+
+  template<typename Weight, typename StoredWeight>
+  void AllPairsRouter<Weight, StoredWeight>::InitializeMatrices() {
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      weights_[vertex * vertex_count_ + vertex] = StoredWeight{};
+      for (const EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+        const Weight edge_weight = graph_.GetEdgeWeight(edge_id);
+        if (edge_weight < ZERO_WEIGHT) {
+          throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const size_t cell = vertex * vertex_count_ + graph_.GetEdgeTarget(edge_id);
+        if (static_cast<StoredWeight>(edge_weight) < weights_[cell]) {
+          weights_[cell] = static_cast<StoredWeight>(edge_weight);
+          prev_edges_[cell] = static_cast<PrevEdgeId>(edge_id);
+        }
+      }
+    }
+  }
+
+  template<typename Weight, typename StoredWeight>
+  void AllPairsRouter<Weight, StoredWeight>::RelaxBlock(size_t row_block, size_t column_block, size_t through_block) {
+    const size_t row_begin = row_block * block_size_;
+    const size_t row_end = std::min(row_begin + block_size_, vertex_count_);
+    const size_t column_begin = column_block * block_size_;
+    const size_t column_end = std::min(column_begin + block_size_, vertex_count_);
+    const size_t through_begin = through_block * block_size_;
+    const size_t through_end = std::min(through_begin + block_size_, vertex_count_);
+
+    for (size_t vertex_through = through_begin; vertex_through < through_end; ++vertex_through) {
+      const StoredWeight *weights_through = weights_.data() + vertex_through * vertex_count_;
+      const PrevEdgeId *prev_edges_through = prev_edges_.data() + vertex_through * vertex_count_;
+      for (size_t vertex_from = row_begin; vertex_from < row_end; ++vertex_from) {
+        StoredWeight *weights_from = weights_.data() + vertex_from * vertex_count_;
+        PrevEdgeId *prev_edges_from = prev_edges_.data() + vertex_from * vertex_count_;
+        const StoredWeight weight_to_through = weights_from[vertex_through];
+        if (!(weight_to_through < INFINITE_WEIGHT)) {
+          continue;
+        }
+        // Внутренний цикл без ветвлений, чтобы компилятор мог его векторизовать
+        for (size_t vertex_to = column_begin; vertex_to < column_end; ++vertex_to) {
+          const StoredWeight candidate_weight = weight_to_through + weights_through[vertex_to];
+          const bool is_better = candidate_weight < weights_from[vertex_to];
+          weights_from[vertex_to] = is_better ? candidate_weight : weights_from[vertex_to];
+          prev_edges_from[vertex_to] = is_better ? prev_edges_through[vertex_to] : prev_edges_from[vertex_to];
+        }
+      }
+    }
+  }
+
+  template<typename Weight, typename StoredWeight>
+  std::optional<Weight> AllPairsRouter<Weight, StoredWeight>::GetRouteWeight(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+      throw std::out_of_range("Vertex id is out of range");
+    }
+    const StoredWeight weight = weights_[from * vertex_count_ + to];
+    if (!(weight < INFINITE_WEIGHT)) {
+      return std::nullopt;
+    }
+    if constexpr (IS_EXACT) {
+      return weight;
+    } else {
+      return SumEdgeWeights(ReconstructEdges(from, to));
+    }
+  }
+
+  template<typename Weight, typename StoredWeight>
+  std::optional<typename AllPairsRouter<Weight, StoredWeight>::RouteInfo>
+  AllPairsRouter<Weight, StoredWeight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+      throw std::out_of_range("Vertex id is out of range");
+    }
+    const StoredWeight weight = weights_[from * vertex_count_ + to];
+    if (!(weight < INFINITE_WEIGHT)) {
+      return std::nullopt;
+    }
+    std::vector<EdgeId> edges = ReconstructEdges(from, to);
+    if constexpr (IS_EXACT) {
+      return RouteInfo{weight, std::move(edges)};
+    } else {
+      const Weight exact_weight = SumEdgeWeights(edges);
+      return RouteInfo{exact_weight, std::move(edges)};
+    }
+  }
+
+  template<typename Weight, typename StoredWeight>
+  std::vector<EdgeId> AllPairsRouter<Weight, StoredWeight>::ReconstructEdges(VertexId from, VertexId to) const {
+    std::vector<EdgeId> edges;
+    for (PrevEdgeId edge_id = prev_edges_[from * vertex_count_ + to];
+         edge_id != NO_PREV_EDGE && edges.size() < vertex_count_;
+         edge_id = prev_edges_[from * vertex_count_ + graph_.GetEdgeSource(edge_id)]) {
+      edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    return edges;
+  }
+
+  template<typename Weight, typename StoredWeight>
+  Weight AllPairsRouter<Weight, StoredWeight>::SumEdgeWeights(const std::vector<EdgeId> &edges) const {
+    Weight result = ZERO_WEIGHT;
+    for (const EdgeId edge_id: edges) {
+      result += graph_.GetEdgeWeight(edge_id);
+    }
+    return result;
+  }
+
+} // namespace graph
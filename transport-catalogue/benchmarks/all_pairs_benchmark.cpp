@@ -0,0 +1,152 @@
+// Сравнение прежнего Router, который строил таблицу всех пар тройным циклом по ячейкам
+// std::optional, с блочным graph::AllPairsRouter.
+// Запуск: all_pairs_benchmark [vertex_count] [edge_count] [threads_count]
+
+#include "all_pairs_router.h"
+#include "graph.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+  // Прежняя реализация Router из исходной версии справочника
+  template<typename Weight>
+  class ReferenceRouter {
+  private:
+    using Graph = graph::DirectedWeightedGraph<Weight>;
+
+  public:
+    explicit ReferenceRouter(const Graph &graph)
+        : routes_internal_data_(graph.GetVertexCount(),
+                                std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount())) {
+      const size_t vertex_count = graph.GetVertexCount();
+      for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        for (const graph::EdgeId edge_id: graph.GetIncidentEdges(vertex)) {
+          const auto edge = graph.GetEdge(edge_id);
+          auto &route_internal_data = routes_internal_data_[vertex][edge.to];
+          if (!route_internal_data || route_internal_data->weight > edge.weight) {
+            route_internal_data = RouteInternalData{edge.weight, edge_id};
+          }
+        }
+      }
+      for (graph::VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+        for (graph::VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+          if (const auto &route_from = routes_internal_data_[vertex_from][vertex_through]) {
+            for (graph::VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+              if (const auto &route_to = routes_internal_data_[vertex_through][vertex_to]) {
+                auto &route_relaxing = routes_internal_data_[vertex_from][vertex_to];
+                const Weight candidate_weight = route_from->weight + route_to->weight;
+                if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+                  route_relaxing = {candidate_weight, route_to->prev_edge ? route_to->prev_edge : route_from->prev_edge};
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+    std::optional<Weight> GetRouteWeight(graph::VertexId from, graph::VertexId to) const {
+      const auto &route_internal_data = routes_internal_data_[from][to];
+      if (!route_internal_data) {
+        return std::nullopt;
+      }
+      return route_internal_data->weight;
+    }
+
+  private:
+    struct RouteInternalData {
+      Weight weight;
+      std::optional<graph::EdgeId> prev_edge;
+    };
+
+    static constexpr Weight ZERO_WEIGHT{};
+    std::vector<std::vector<std::optional<RouteInternalData>>> routes_internal_data_;
+  };
+
+  graph::DirectedWeightedGraph<double> MakeRandomGraph(size_t vertex_count, size_t edge_count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<graph::VertexId> vertex_distribution(0, vertex_count - 1);
+    std::uniform_real_distribution<double> weight_distribution(1., 100.);
+    graph::GraphBuilder<double> builder(vertex_count);
+    for (size_t i = 0; i < edge_count; ++i) {
+      builder.AddEdge({vertex_distribution(generator), vertex_distribution(generator),
+                       weight_distribution(generator), 0, 1});
+    }
+    return builder.Build();
+  }
+
+  template<typename Function>
+  double MeasureSeconds(Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  size_t ParseArgument(int argc, char *argv[], int index, size_t default_value) {
+    return argc > index ? std::stoul(argv[index]) : default_value;
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+  const size_t vertex_count = ParseArgument(argc, argv, 1, 1500);
+  const size_t edge_count = ParseArgument(argc, argv, 2, vertex_count * 4);
+  const size_t threads_count = ParseArgument(argc, argv, 3, 1);
+  if (vertex_count == 0) {
+    std::cerr << "vertex_count should be positive\n"sv;
+    return 1;
+  }
+  const auto graph = MakeRandomGraph(vertex_count, edge_count);
+  std::cout << "vertices: "sv << vertex_count << ", edges: "sv << edge_count
+            << ", threads: "sv << threads_count << '\n';
+
+  std::optional<ReferenceRouter<double>> reference_router;
+  const double reference_seconds = MeasureSeconds([&] {
+    reference_router.emplace(graph);
+  });
+  std::cout << "reference Router: "sv << reference_seconds << " s\n"sv;
+
+  std::optional<graph::AllPairsRouter<double>> all_pairs_router;
+  const double all_pairs_seconds = MeasureSeconds([&] {
+    all_pairs_router.emplace(graph, threads_count);
+  });
+  std::cout << "AllPairsRouter: "sv << all_pairs_seconds << " s ("sv
+            << reference_seconds / all_pairs_seconds << "x)\n"sv;
+
+  std::optional<graph::AllPairsRouter<double, float>> compact_router;
+  const double compact_seconds = MeasureSeconds([&] {
+    compact_router.emplace(graph, threads_count);
+  });
+  std::cout << "AllPairsRouter<double, float>: "sv << compact_seconds << " s ("sv
+            << reference_seconds / compact_seconds << "x)\n"sv;
+
+  // Все пары сверяются с эталоном: точная таблица - до погрешности порядка сложения,
+  // компактная - до погрешности float
+  size_t mismatches = 0;
+  for (graph::VertexId from = 0; from < vertex_count; ++from) {
+    for (graph::VertexId to = 0; to < vertex_count; ++to) {
+      const auto expected = reference_router->GetRouteWeight(from, to);
+      const auto exact = all_pairs_router->GetRouteWeight(from, to);
+      const auto compact = compact_router->GetRouteWeight(from, to);
+      if (expected.has_value() != exact.has_value() || expected.has_value() != compact.has_value()) {
+        ++mismatches;
+      } else if (expected && (std::abs(*expected - *exact) > 1e-9 * *expected
+                              || std::abs(*expected - *compact) > 1e-5 * *expected)) {
+        ++mismatches;
+      }
+    }
+  }
+  std::cout << "mismatched pairs: "sv << mismatches << '\n';
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+// Сравнение прежнего хранения расстояний в unordered_map по паре остановок с индексом
+// расстояний TransportCatalogue. Каждый запрос сверяется с прежней реализацией.
+// Запуск: distance_index_benchmark [stops_count] [segments_count] [lookups_count]
+
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+using transport_catalogue::Stop;
+
+namespace {
+
+  // Прежнее хранение расстояний из исходной версии справочника
+  class ReferenceDistances {
+  public:
+    void SetDistance(int64_t dist, Stop *from, Stop *to) {
+      dist_betw_stops_[{from, to}] = dist;
+    }
+
+    int64_t GetDistance(Stop *from, Stop *to) const {
+      if ((from == to) && (!dist_betw_stops_.count({from, to}))) {
+        return 0;
+      }
+      if (dist_betw_stops_.count({from, to})) {
+        return dist_betw_stops_.at({from, to});
+      } else {
+        return dist_betw_stops_.at({to, from});
+      }
+    }
+
+  private:
+    struct StopsHasher {
+      size_t operator()(const std::pair<Stop *, Stop *> &elem) const {
+        return s_hasher(elem.first) + 37 * s_hasher(elem.second);
+      }
+
+      std::hash<Stop *> s_hasher;
+    };
+
+    std::unordered_map<std::pair<Stop *, Stop *>, int64_t, StopsHasher> dist_betw_stops_;
+  };
+
+  struct Segment {
+    size_t from;
+    size_t to;
+    int64_t distance;
+  };
+
+  // Отрезки между соседними по номеру остановками, как на маршрутах, и случайные пары.
+  // Часть пар задаётся повторно, чтобы проверить, что побеждает последнее значение.
+  std::vector<Segment> MakeSegments(size_t stops_count, size_t segments_count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> stop_distribution(0, stops_count - 1);
+    std::uniform_int_distribution<size_t> offset_distribution(1, 16);
+    std::uniform_int_distribution<int64_t> distance_distribution(100, 5000);
+    std::vector<Segment> segments;
+    segments.reserve(segments_count);
+    for (size_t i = 0; i < segments_count; ++i) {
+      if (i % 10 == 9) {
+        segments.push_back({segments[i / 2].from, segments[i / 2].to, distance_distribution(generator)});
+        continue;
+      }
+      const size_t from = stop_distribution(generator);
+      const size_t to = i % 2 == 0 ? (from + offset_distribution(generator)) % stops_count
+                                   : stop_distribution(generator);
+      segments.push_back({from, to, distance_distribution(generator)});
+    }
+    return segments;
+  }
+
+  template<typename Function>
+  double MeasureSeconds(Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  size_t ParseArgument(int argc, char *argv[], int index, size_t default_value) {
+    return argc > index ? std::stoul(argv[index]) : default_value;
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+  const size_t stops_count = ParseArgument(argc, argv, 1, 200000);
+  const size_t segments_count = ParseArgument(argc, argv, 2, 1000000);
+  const size_t lookups_count = ParseArgument(argc, argv, 3, 5000000);
+  if (stops_count == 0 || segments_count == 0) {
+    std::cerr << "stops_count and segments_count should be positive\n"sv;
+    return 1;
+  }
+  std::cout << "stops: "sv << stops_count << ", segments: "sv << segments_count
+            << ", lookups: "sv << lookups_count << '\n';
+
+  transport_catalogue::TransportCatalogue catalogue;
+  std::vector<Stop *> stops;
+  stops.reserve(stops_count);
+  for (size_t stop_id = 0; stop_id < stops_count; ++stop_id) {
+    stops.push_back(catalogue.AddStop({"Stop "s + std::to_string(stop_id), {55.7, 37.6}}));
+  }
+  const auto segments = MakeSegments(stops_count, segments_count);
+
+  // Запросы в случайном порядке, половина - в обратном направлении, которое не задано явно
+  std::vector<std::pair<Stop *, Stop *>> lookups;
+  lookups.reserve(lookups_count);
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<size_t> segment_distribution(0, segments.size() - 1);
+  for (size_t i = 0; i < lookups_count; ++i) {
+    const Segment &segment = segments[segment_distribution(generator)];
+    lookups.emplace_back(stops[segment.from], stops[segment.to]);
+    if (i % 2 == 1) {
+      std::swap(lookups.back().first, lookups.back().second);
+    }
+  }
+
+  ReferenceDistances reference;
+  const double reference_set_seconds = MeasureSeconds([&] {
+    for (const auto &[from, to, distance]: segments) {
+      reference.SetDistance(distance, stops[from], stops[to]);
+    }
+  });
+  // Индекс строится при первом запросе расстояния, его построение входит во время загрузки
+  const double set_seconds = MeasureSeconds([&] {
+    for (const auto &[from, to, distance]: segments) {
+      catalogue.SetDistance(distance, stops[from], stops[to]);
+    }
+    catalogue.GetDistance(stops[segments[0].from], stops[segments[0].to]);
+  });
+  std::cout << "SetDistance: reference "sv << reference_set_seconds << " s, index with build "sv
+            << set_seconds << " s ("sv << reference_set_seconds / set_seconds << "x)\n"sv;
+
+  std::vector<int64_t> expected(lookups.size());
+  const double reference_get_seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < lookups.size(); ++i) {
+      expected[i] = reference.GetDistance(lookups[i].first, lookups[i].second);
+    }
+  });
+  std::vector<int64_t> actual(lookups.size());
+  const double get_seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < lookups.size(); ++i) {
+      actual[i] = catalogue.GetDistance(lookups[i].first, lookups[i].second);
+    }
+  });
+  std::cout << "GetDistance: reference "sv << reference_get_seconds << " s, index "sv << get_seconds
+            << " s ("sv << reference_get_seconds / get_seconds << "x)\n"sv;
+
+  // Обновление уже проиндексированных пар не перестраивает индекс
+  const size_t updates_count = std::min<size_t>(segments.size(), 100000);
+  const double update_seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < updates_count; ++i) {
+      const Segment &segment = segments[i];
+      catalogue.SetDistance(segment.distance + 1, stops[segment.to], stops[segment.from]);
+      catalogue.GetDistance(stops[segment.from], stops[segment.to]);
+    }
+  });
+  for (size_t i = 0; i < updates_count; ++i) {
+    const Segment &segment = segments[i];
+    reference.SetDistance(segment.distance + 1, stops[segment.to], stops[segment.from]);
+  }
+  std::cout << "SetDistance and GetDistance on indexed pairs: "sv << updates_count << " updates in "sv
+            << update_seconds << " s\n"sv;
+
+  size_t mismatches = 0;
+  for (size_t i = 0; i < lookups.size(); ++i) {
+    if (expected[i] != actual[i]) {
+      ++mismatches;
+    }
+  }
+  for (const auto &[from, to]: lookups) {
+    if (reference.GetDistance(from, to) != catalogue.GetDistance(from, to)) {
+      ++mismatches;
+    }
+  }
+  std::cout << "mismatched lookups: "sv << mismatches << '\n';
+  return mismatches == 0 ? 0 : 1;
+}
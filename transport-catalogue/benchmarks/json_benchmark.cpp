@@ -0,0 +1,306 @@
+// Сравнение прежнего разбора JSON, читавшего поток посимвольно через istream, с json::Reader
+// и с потоковой загрузкой base_requests. Входной документ генерируется в памяти.
+// Запуск: json_benchmark [stops_count] [buses_count]
+
+#include "json.h"
+#include "json_reader.h"
+#include "transport_catalogue.h"
+
+#include <chrono>
+#include <cctype>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <variant>
+
+using namespace std::literals;
+
+namespace {
+
+  // Прежний разбор из исходной версии json.cpp
+  namespace reference {
+
+    json::Node LoadNode(std::istream &input);
+
+    json::Node LoadArray(std::istream &input) {
+      json::Array result;
+      char c;
+      for (; input >> c && c != ']';) {
+        if (c != ',') {
+          input.putback(c);
+        }
+        result.push_back(LoadNode(input));
+      }
+      if (c != ']') {
+        throw json::ParsingError("Bad data for array");
+      }
+      return json::Node(std::move(result));
+    }
+
+    std::variant<int, double> LoadNumber(std::istream &input) {
+      std::string parsed_num;
+
+      auto read_char = [&parsed_num, &input] {
+        parsed_num += static_cast<char>(input.get());
+        if (!input) {
+          throw json::ParsingError("Failed to read number from stream"s);
+        }
+      };
+
+      auto read_digits = [&input, read_char] {
+        if (!std::isdigit(input.peek())) {
+          throw json::ParsingError("A digit is expected"s);
+        }
+        while (std::isdigit(input.peek())) {
+          read_char();
+        }
+      };
+
+      if (input.peek() == '-') {
+        read_char();
+      }
+      if (input.peek() == '0') {
+        read_char();
+      } else {
+        read_digits();
+      }
+
+      bool is_int = true;
+      if (input.peek() == '.') {
+        read_char();
+        read_digits();
+        is_int = false;
+      }
+
+      if (int ch = input.peek(); ch == 'e' || ch == 'E') {
+        read_char();
+        if (ch = input.peek(); ch == '+' || ch == '-') {
+          read_char();
+        }
+        read_digits();
+        is_int = false;
+      }
+
+      try {
+        if (is_int) {
+          try {
+            return std::stoi(parsed_num);
+          }
+          catch (...) {
+          }
+        }
+        return std::stod(parsed_num);
+      }
+      catch (...) {
+        throw json::ParsingError("Failed to convert "s + parsed_num + " to number"s);
+      }
+    }
+
+    std::string LoadString(std::istream &input) {
+      auto it = std::istreambuf_iterator<char>(input);
+      auto end = std::istreambuf_iterator<char>();
+      std::string s;
+      while (true) {
+        if (it == end) {
+          throw json::ParsingError("String parsing error");
+        }
+        const char ch = *it;
+        if (ch == '"') {
+          ++it;
+          break;
+        } else if (ch == '\\') {
+          ++it;
+          if (it == end) {
+            throw json::ParsingError("String parsing error");
+          }
+          const char escaped_char = *(it);
+          switch (escaped_char) {
+            case 'n':
+              s.push_back('\n');
+              break;
+            case 't':
+              s.push_back('\t');
+              break;
+            case 'r':
+              s.push_back('\r');
+              break;
+            case '"':
+              s.push_back('"');
+              break;
+            case '\\':
+              s.push_back('\\');
+              break;
+            default:
+              throw json::ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+          }
+        } else if (ch == '\n' || ch == '\r') {
+          throw json::ParsingError("Unexpected end of line"s);
+        } else {
+          s.push_back(ch);
+        }
+        ++it;
+      }
+      return s;
+    }
+
+    json::Node LoadDict(std::istream &input) {
+      json::Dict result;
+      char c;
+      for (; input >> c && c != '}';) {
+        if (c == ',') {
+          input >> c;
+        }
+        std::string key = LoadString(input);
+        input >> c;
+        result.insert({std::move(key), LoadNode(input)});
+      }
+      if (c != '}' && c != ':') {
+        throw json::ParsingError("Bad data for dictionary");
+      }
+      return json::Node(std::move(result));
+    }
+
+    json::Node LoadLiteral(std::istream &input, char c, std::string_view literal, json::Node value,
+                           const char *error) {
+      std::string line(literal.size(), '\0');
+      input.putback(c);
+      input.read(line.data(), static_cast<std::streamsize>(line.size()));
+      if (line.find(literal) == std::string::npos) {
+        throw json::ParsingError(error);
+      }
+      return value;
+    }
+
+    json::Node LoadNode(std::istream &input) {
+      char c;
+      input >> c;
+      if (c == '[') {
+        return LoadArray(input);
+      } else if (c == '{') {
+        return LoadDict(input);
+      } else if (c == '"') {
+        return json::Node(LoadString(input));
+      } else if (c == 'n') {
+        return LoadLiteral(input, c, "null"sv, json::Node(), "Bad data for null");
+      } else if (c == 't') {
+        return LoadLiteral(input, c, "true"sv, json::Node(true), "Bad data bool");
+      } else if (c == 'f') {
+        return LoadLiteral(input, c, "false"sv, json::Node(false), "Bad data bool");
+      } else if (c == ']') {
+        throw json::ParsingError("Bad data for array");
+      } else if (c == '}') {
+        throw json::ParsingError("Bad data for dictionary");
+      }
+      input.putback(c);
+      const auto number = LoadNumber(input);
+      if (const int *value = std::get_if<int>(&number)) {
+        return json::Node(*value);
+      }
+      return json::Node(std::get<double>(number));
+    }
+
+  }  // namespace reference
+
+  std::string MakeStopName(size_t stop_id) {
+    return "Stop "s + std::to_string(stop_id);
+  }
+
+  // Документ в формате входных данных справочника: остановки с расстояниями до соседей,
+  // маршруты по случайным остановкам и запросы к ним
+  std::string MakeDocument(size_t stops_count, size_t buses_count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> stop_distribution(0, stops_count - 1);
+    std::uniform_real_distribution<double> lat_distribution(55.5, 55.9);
+    std::uniform_real_distribution<double> lng_distribution(37.3, 37.9);
+    std::uniform_int_distribution<int> road_distribution(100, 5000);
+
+    std::ostringstream out;
+    out.precision(15);
+    out << "{\"base_requests\": [";
+    for (size_t stop_id = 0; stop_id < stops_count; ++stop_id) {
+      out << (stop_id == 0 ? "" : ", ") << "{\"type\": \"Stop\", \"name\": \"" << MakeStopName(stop_id)
+          << "\", \"latitude\": " << lat_distribution(generator)
+          << ", \"longitude\": " << lng_distribution(generator) << ", \"road_distances\": {";
+      for (size_t i = 0; i < 6; ++i) {
+        out << (i == 0 ? "" : ", ") << '"' << MakeStopName(stop_distribution(generator)) << "\": "
+            << road_distribution(generator);
+      }
+      out << "}}";
+    }
+    for (size_t bus_id = 0; bus_id < buses_count; ++bus_id) {
+      out << ", {\"type\": \"Bus\", \"name\": \"Bus \\\"" << bus_id << "\\\"\", \"stops\": [";
+      for (size_t i = 0; i < 20; ++i) {
+        out << (i == 0 ? "" : ", ") << '"' << MakeStopName(stop_distribution(generator)) << '"';
+      }
+      out << "], \"is_roundtrip\": " << (bus_id % 2 == 0 ? "true" : "false") << '}';
+    }
+    out << "],\n\"routing_settings\": {\"bus_wait_time\": 6, \"bus_velocity\": 40},\n"
+           "\"render_settings\": {\"width\": 1200.0, \"height\": 1200.0, \"padding\": 50.0, \"line_width\": 14.0,"
+           " \"stop_radius\": 5.0, \"bus_label_font_size\": 20, \"bus_label_offset\": [7.0, 15.0],"
+           " \"stop_label_font_size\": 20, \"stop_label_offset\": [7.0, -3.0],"
+           " \"underlayer_color\": [255, 255, 255, 0.85], \"underlayer_width\": 3.0,"
+           " \"color_palette\": [\"green\", [255, 160, 0], \"red\"]},\n\"stat_requests\": [";
+    for (size_t request_id = 0; request_id < stops_count; ++request_id) {
+      out << (request_id == 0 ? "" : ", ") << "{\"id\": " << request_id << ", \"type\": \"Route\", \"from\": \""
+          << MakeStopName(stop_distribution(generator)) << "\", \"to\": \""
+          << MakeStopName(stop_distribution(generator)) << "\"}";
+    }
+    out << "]}";
+    return out.str();
+  }
+
+  template<typename Function>
+  double MeasureSeconds(Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  size_t ParseArgument(int argc, char *argv[], int index, size_t default_value) {
+    return argc > index ? std::stoul(argv[index]) : default_value;
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+  const size_t stops_count = ParseArgument(argc, argv, 1, 100000);
+  const size_t buses_count = ParseArgument(argc, argv, 2, stops_count / 4);
+  if (stops_count == 0) {
+    std::cerr << "stops_count should be positive\n"sv;
+    return 1;
+  }
+  const std::string text = MakeDocument(stops_count, buses_count);
+  std::cout << "stops: "sv << stops_count << ", buses: "sv << buses_count
+            << ", document: "sv << text.size() / (1 << 20) << " MiB\n"sv;
+
+  json::Node reference_root;
+  const double reference_seconds = MeasureSeconds([&] {
+    std::istringstream input(text);
+    reference_root = reference::LoadNode(input);
+  });
+  std::cout << "reference istream parser: "sv << reference_seconds << " s\n"sv;
+
+  // Вместе с чтением потока в строку, как при разборе stdin
+  std::optional<json::Document> document;
+  const double reader_seconds = MeasureSeconds([&] {
+    std::istringstream input(text);
+    document.emplace(json::Load(input));
+  });
+  std::cout << "json::Load: "sv << reader_seconds << " s ("sv
+            << reference_seconds / reader_seconds << "x)\n"sv;
+
+  // Потоковая загрузка заодно заполняет справочник, поэтому делает больше работы, чем разбор
+  transport_catalogue::TransportCatalogue catalogue;
+  const double streaming_seconds = MeasureSeconds([&] {
+    std::istringstream input(text);
+    transport_catalogue::LoadRequestsDocument(input, catalogue);
+  });
+  std::cout << "LoadRequestsDocument with catalogue filling: "sv << streaming_seconds << " s ("sv
+            << reference_seconds / streaming_seconds << "x)\n"sv;
+
+  const bool is_same = document->GetRoot() == reference_root;
+  std::cout << "documents match: "sv << (is_same ? "yes"sv : "no"sv) << '\n';
+  return is_same ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+// Сравнение поиска ближайших остановок и остановок в радиусе через geo::SpatialIndex
+// с полным перебором, по которому проверяются результаты.
+// Запуск: spatial_index_benchmark [points_count] [queries_count]
+
+#include "geo.h"
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+  // Все точки по возрастанию (расстояние, номер)
+  std::vector<std::pair<double, size_t>> ScanAll(const std::vector<geo::Coordinates> &points,
+                                                 geo::Coordinates point) {
+    std::vector<std::pair<double, size_t>> result;
+    result.reserve(points.size());
+    for (size_t point_id = 0; point_id < points.size(); ++point_id) {
+      double distance = geo::ComputeDistance(point, points[point_id]);
+      if (std::isnan(distance)) {
+        distance = 0;
+      }
+      result.emplace_back(distance, point_id);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  // Перебор, который сортирует только то, что попадает в ответ
+  std::vector<std::pair<double, size_t>> ScanNearest(const std::vector<geo::Coordinates> &points,
+                                                     geo::Coordinates point, size_t count) {
+    std::vector<std::pair<double, size_t>> result;
+    result.reserve(points.size());
+    for (size_t point_id = 0; point_id < points.size(); ++point_id) {
+      result.emplace_back(geo::ComputeDistance(point, points[point_id]), point_id);
+    }
+    count = std::min(count, result.size());
+    std::partial_sort(result.begin(), result.begin() + count, result.end());
+    result.resize(count);
+    return result;
+  }
+
+  std::vector<std::pair<double, size_t>> ScanInRadius(const std::vector<geo::Coordinates> &points,
+                                                      geo::Coordinates point, double radius) {
+    std::vector<std::pair<double, size_t>> result;
+    for (size_t point_id = 0; point_id < points.size(); ++point_id) {
+      const double distance = geo::ComputeDistance(point, points[point_id]);
+      if (distance <= radius) {
+        result.emplace_back(distance, point_id);
+      }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  // Большая часть точек - в пределах города, остальные разбросаны по всей сфере.
+  // Добавлены точки по обе стороны 180-го меридиана и совпадающие точки.
+  std::vector<geo::Coordinates> MakePoints(size_t points_count, std::mt19937 &generator) {
+    std::uniform_real_distribution<double> city_lat(55.5, 56.0);
+    std::uniform_real_distribution<double> city_lng(37.3, 37.9);
+    std::uniform_real_distribution<double> lat(-89.9, 89.9);
+    std::uniform_real_distribution<double> lng(-180., 180.);
+    std::vector<geo::Coordinates> points;
+    points.reserve(points_count + 3);
+    for (size_t i = 0; i < points_count; ++i) {
+      points.push_back(i % 10 != 0 ? geo::Coordinates{city_lat(generator), city_lng(generator)}
+                                   : geo::Coordinates{lat(generator), lng(generator)});
+    }
+    points.push_back({10., 179.9999});
+    points.push_back({10., -179.9999});
+    points.push_back(points.front());
+    return points;
+  }
+
+  std::vector<geo::Coordinates> MakeCityQueries(size_t queries_count, std::mt19937 &generator) {
+    std::uniform_real_distribution<double> city_lat(55.5, 56.0);
+    std::uniform_real_distribution<double> city_lng(37.3, 37.9);
+    std::vector<geo::Coordinates> queries;
+    queries.reserve(queries_count);
+    for (size_t i = 0; i < queries_count; ++i) {
+      queries.push_back({city_lat(generator), city_lng(generator)});
+    }
+    return queries;
+  }
+
+  template<typename Function>
+  double MeasureSeconds(Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  size_t ParseArgument(int argc, char *argv[], int index, size_t default_value) {
+    return argc > index ? std::stoul(argv[index]) : default_value;
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+  constexpr size_t NEAREST_COUNT = 10;
+  constexpr double RADIUS = 300.;
+  const size_t points_count = ParseArgument(argc, argv, 1, 100000);
+  const size_t queries_count = ParseArgument(argc, argv, 2, 10000);
+  if (queries_count == 0) {
+    std::cerr << "queries_count should be positive\n"sv;
+    return 1;
+  }
+  std::mt19937 generator(42);
+  const auto points = MakePoints(points_count, generator);
+  const auto queries = MakeCityQueries(queries_count, generator);
+  std::cout << "points: "sv << points.size() << ", queries: "sv << queries_count << '\n';
+
+  std::optional<geo::SpatialIndex> index;
+  const double build_seconds = MeasureSeconds([&] {
+    index.emplace(points);
+  });
+  std::cout << "build: "sv << build_seconds << " s\n"sv;
+
+  size_t found_count = 0;
+  const double nearest_seconds = MeasureSeconds([&] {
+    for (const auto &query: queries) {
+      found_count += index->FindNearest(query, NEAREST_COUNT).size();
+    }
+  });
+  const double radius_seconds = MeasureSeconds([&] {
+    for (const auto &query: queries) {
+      found_count += index->FindInRadius(query, RADIUS).size();
+    }
+  });
+  // Перебор на части запросов, иначе он занимает минуты
+  const size_t scan_queries_count = std::min<size_t>(queries_count, 100);
+  const double scan_nearest_seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < scan_queries_count; ++i) {
+      found_count += ScanNearest(points, queries[i], NEAREST_COUNT).size();
+    }
+  });
+  const double scan_radius_seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < scan_queries_count; ++i) {
+      found_count += ScanInRadius(points, queries[i], RADIUS).size();
+    }
+  });
+  auto per_query_us = [](double seconds, size_t count) {
+    return seconds * 1e6 / static_cast<double>(count);
+  };
+  const double nearest_us = per_query_us(nearest_seconds, queries_count);
+  const double radius_us = per_query_us(radius_seconds, queries_count);
+  const double scan_nearest_us = per_query_us(scan_nearest_seconds, scan_queries_count);
+  const double scan_radius_us = per_query_us(scan_radius_seconds, scan_queries_count);
+  std::cout << "nearest "sv << NEAREST_COUNT << ": linear scan "sv << scan_nearest_us << " us/query, index "sv
+            << nearest_us << " us/query ("sv << scan_nearest_us / nearest_us << "x)\n"sv
+            << "radius "sv << RADIUS << " m: linear scan "sv << scan_radius_us << " us/query, index "sv
+            << radius_us << " us/query ("sv << scan_radius_us / radius_us << "x)\n"sv
+            << "found: "sv << found_count << '\n';
+
+  // Проверка по перебору: городские запросы, случайные по сфере, у 180-го меридиана,
+  // в совпадающей точке и на полюсе
+  std::vector<geo::Coordinates> checked_queries(queries.begin(), queries.begin() + scan_queries_count);
+  std::uniform_real_distribution<double> lat(-90., 90.);
+  std::uniform_real_distribution<double> lng(-180., 180.);
+  for (size_t i = 0; i < 50; ++i) {
+    checked_queries.push_back({lat(generator), lng(generator)});
+  }
+  checked_queries.push_back({10., 180.});
+  checked_queries.push_back(points.front());
+  checked_queries.push_back({90., 0.});
+
+  size_t mismatches = 0;
+  for (const auto &query: checked_queries) {
+    const auto expected = ScanAll(points, query);
+    const auto nearest = index->FindNearest(query, NEAREST_COUNT);
+    // При равных расстояниях до соседей порядок может отличаться, поэтому сравниваются расстояния
+    if (nearest.size() != std::min(NEAREST_COUNT, expected.size())) {
+      ++mismatches;
+    } else {
+      for (size_t i = 0; i < nearest.size(); ++i) {
+        if (std::abs(nearest[i].second - expected[i].first) > 1e-6) {
+          ++mismatches;
+          break;
+        }
+      }
+    }
+    for (const double radius: {RADIUS, 2000., 500000.}) {
+      const auto in_radius = index->FindInRadius(query, radius);
+      const size_t expected_count = std::upper_bound(expected.begin(), expected.end(),
+                                                     std::pair{radius, points.size()}) - expected.begin();
+      bool is_same = in_radius.size() == expected_count;
+      for (size_t i = 0; is_same && i < expected_count; ++i) {
+        is_same = in_radius[i].first == expected[i].second;
+      }
+      if (!is_same) {
+        ++mismatches;
+      }
+    }
+  }
+  std::cout << "checked queries: "sv << checked_queries.size() << ", mismatches: "sv << mismatches << '\n';
+  return mismatches == 0 ? 0 : 1;
+}
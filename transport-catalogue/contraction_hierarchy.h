@@ -0,0 +1,599 @@
+#pragma once
+
+#include "graph.h"
+#include "parallel.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+  // Иерархия сжатий (contraction hierarchies) над неизменяемым графом.
+  // Вершины один раз сжимаются в порядке важности с добавлением рёбер-сокращений,
+  // запрос - двунаправленный поиск только "вверх" по рангам. Найденный путь
+  // раскрывается обратно в идентификаторы рёбер исходного графа.
+  template<typename Weight>
+  class ContractionHierarchy {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    // Ограничение числа вершин, просматриваемых при поиске свидетеля
+    static constexpr size_t DEFAULT_WITNESS_SETTLE_LIMIT = 500;
+
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    // Дуги с идентификаторами меньше числа рёбер графа - исходные рёбра,
+    // остальные - сокращения, заменяющие пару дуг через сжатую вершину
+    using ArcId = size_t;
+
+    struct Shortcut {
+      ArcId first;
+      ArcId second;
+    };
+
+    struct SearchArc {
+      VertexId vertex;
+      Weight weight;
+      ArcId arc_id;
+    };
+
+    // Результат предобработки. Дуги поиска вершины v лежат в *_arcs[*_offsets[v]..*_offsets[v + 1])
+    struct Data {
+      std::vector<Shortcut> shortcuts;
+      std::vector<size_t> ranks;
+      std::vector<size_t> upward_offsets;
+      std::vector<SearchArc> upward_arcs;
+      std::vector<size_t> downward_offsets;
+      std::vector<SearchArc> downward_arcs;
+    };
+
+    explicit ContractionHierarchy(const Graph &graph, size_t witness_settle_limit = DEFAULT_WITNESS_SETTLE_LIMIT);
+
+    // Восстанавливает иерархию без повторного сжатия
+    ContractionHierarchy(const Graph &graph, Data data);
+
+    Data GetData() const;
+
+    // stats получает число вершин, извлечённых из очередей обоих направлений
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, SearchStats *stats = nullptr) const;
+
+    // Матрица весов кратчайших путей sources x targets. Используется схема с корзинами:
+    // поиск вниз от каждой цели раскладывает веса по вершинам, поиск вверх от каждого
+    // источника собирает их. Поиски одного направления выполняются параллельно.
+    std::vector<std::vector<std::optional<Weight>>> BuildWeightsMatrix(const std::vector<VertexId> &sources,
+                                                                       const std::vector<VertexId> &targets,
+                                                                       size_t threads_count = 0) const;
+
+    const Graph &GetGraph() const {
+      return graph_;
+    }
+
+    size_t GetShortcutsCount() const {
+      return shortcuts_.size();
+    }
+
+  private:
+    struct Arc {
+      VertexId vertex;
+      Weight weight;
+      ArcId arc_id;
+    };
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                              ? std::numeric_limits<Weight>::infinity()
+                                              : std::numeric_limits<Weight>::max();
+    static constexpr ArcId NO_ARC = std::numeric_limits<ArcId>::max();
+
+    void InitializeWorkingGraph();
+
+    void Contract();
+
+    // Обходит пары соседей вершины и вызывает add_shortcut для тех, между которыми
+    // нет пути-свидетеля не длиннее пути через вершину
+    template<typename AddShortcut>
+    void ForEachNeededShortcut(VertexId vertex, size_t settle_limit, AddShortcut add_shortcut);
+
+    int ComputePriority(VertexId vertex);
+
+    void AddArc(VertexId from, VertexId to, Weight weight, ArcId arc_id);
+
+    static void RemoveArc(std::vector<Arc> &arcs, VertexId vertex);
+
+    void UnpackArc(ArcId arc_id, std::vector<EdgeId> &edges) const;
+
+    // Полный поиск вверх по рангам от start. Возвращает просмотренные вершины с весами,
+    // вершины, отсечённые stall-on-demand, в результат не попадают.
+    std::vector<std::pair<VertexId, Weight>> SearchUpward(VertexId start,
+                                                         const std::vector<std::vector<SearchArc>> &arcs,
+                                                         const std::vector<std::vector<SearchArc>> &stall_arcs) const;
+
+    const Graph &graph_;
+    size_t witness_settle_limit_;
+
+    // Рабочий граф из ещё не сжатых вершин, существующий только во время сжатия
+    std::vector<std::vector<Arc>> out_arcs_;
+    std::vector<std::vector<Arc>> in_arcs_;
+    std::vector<bool> contracted_;
+    std::vector<int> contracted_neighbors_;
+    std::vector<Weight> witness_weights_;
+    std::vector<VertexId> witness_touched_;
+
+    std::vector<Shortcut> shortcuts_;
+    std::vector<size_t> ranks_;
+    // Дуги к вершинам большего ранга: прямые для поиска от начала, обратные - от конца
+    std::vector<std::vector<SearchArc>> upward_arcs_;
+    std::vector<std::vector<SearchArc>> downward_arcs_;
+  };
+
+  template<typename Weight>
+  ContractionHierarchy<Weight>::ContractionHierarchy(const Graph &graph, size_t witness_settle_limit)
+      : graph_(graph), witness_settle_limit_(witness_settle_limit) {
+    InitializeWorkingGraph();
+    Contract();
+  }
+
+  template<typename Weight>
+  ContractionHierarchy<Weight>::ContractionHierarchy(const Graph &graph, Data data)
+      : graph_(graph), witness_settle_limit_(DEFAULT_WITNESS_SETTLE_LIMIT),
+        shortcuts_(std::move(data.shortcuts)), ranks_(std::move(data.ranks)) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const size_t arcs_count = graph_.GetEdgeCount() + shortcuts_.size();
+    if (ranks_.size() != vertex_count) {
+      throw std::invalid_argument("Contraction hierarchy does not match the graph");
+    }
+    for (const Shortcut &shortcut: shortcuts_) {
+      if (shortcut.first >= arcs_count || shortcut.second >= arcs_count) {
+        throw std::invalid_argument("Arc id is out of range");
+      }
+    }
+    auto unflatten = [vertex_count, arcs_count](const std::vector<size_t> &offsets,
+                                                const std::vector<SearchArc> &flat_arcs) {
+      if (offsets.size() != vertex_count + 1 || offsets.front() != 0 || offsets.back() != flat_arcs.size()
+          || !std::is_sorted(offsets.begin(), offsets.end())) {
+        throw std::invalid_argument("Contraction hierarchy does not match the graph");
+      }
+      std::vector<std::vector<SearchArc>> result(vertex_count);
+      for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        result[vertex].assign(flat_arcs.begin() + offsets[vertex], flat_arcs.begin() + offsets[vertex + 1]);
+        for (const SearchArc &arc: result[vertex]) {
+          if (arc.vertex >= vertex_count || arc.arc_id >= arcs_count) {
+            throw std::invalid_argument("Arc is out of range");
+          }
+        }
+      }
+      return result;
+    };
+    upward_arcs_ = unflatten(data.upward_offsets, data.upward_arcs);
+    downward_arcs_ = unflatten(data.downward_offsets, data.downward_arcs);
+  }
+
+  template<typename Weight>
+  typename ContractionHierarchy<Weight>::Data ContractionHierarchy<Weight>::GetData() const {
+    auto flatten = [](const std::vector<std::vector<SearchArc>> &arcs, std::vector<size_t> &offsets,
+                      std::vector<SearchArc> &flat_arcs) {
+      offsets.assign(1, 0);
+      for (const auto &vertex_arcs: arcs) {
+        flat_arcs.insert(flat_arcs.end(), vertex_arcs.begin(), vertex_arcs.end());
+        offsets.push_back(flat_arcs.size());
+      }
+    };
+    Data result{shortcuts_, ranks_, {}, {}, {}, {}};
+    flatten(upward_arcs_, result.upward_offsets, result.upward_arcs);
+    flatten(downward_arcs_, result.downward_offsets, result.downward_arcs);
+    return result;
+  }
+
+  template<typename Weight>
+  void ContractionHierarchy<Weight>::InitializeWorkingGraph() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    out_arcs_.assign(vertex_count, {});
+    in_arcs_.assign(vertex_count, {});
+    contracted_.assign(vertex_count, false);
+    contracted_neighbors_.assign(vertex_count, 0);
+    witness_weights_.assign(vertex_count, INFINITE_WEIGHT);
+    ranks_.assign(vertex_count, 0);
+
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      for (const EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+        const Weight weight = graph_.GetEdgeWeight(edge_id);
+        if (weight < ZERO_WEIGHT) {
+          throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const VertexId target = graph_.GetEdgeTarget(edge_id);
+        // Петли никогда не сокращают путь
+        if (target != vertex) {
+          AddArc(vertex, target, weight, edge_id);
+        }
+      }
+    }
+  }
+
+  template<typename Weight>
+  void ContractionHierarchy<Weight>::AddArc(VertexId from, VertexId to, Weight weight, ArcId arc_id) {
+    // Из параллельных дуг хранится только самая короткая
+    auto it = std::find_if(out_arcs_[from].begin(), out_arcs_[from].end(),
+                           [to](const Arc &arc) { return arc.vertex == to; });
+    if (it != out_arcs_[from].end()) {
+      if (!(weight < it->weight)) {
+        return;
+      }
+      *it = {to, weight, arc_id};
+      auto in_it = std::find_if(in_arcs_[to].begin(), in_arcs_[to].end(),
+                                [from](const Arc &arc) { return arc.vertex == from; });
+      *in_it = {from, weight, arc_id};
+      return;
+    }
+    out_arcs_[from].push_back({to, weight, arc_id});
+    in_arcs_[to].push_back({from, weight, arc_id});
+  }
+
+  template<typename Weight>
+  void ContractionHierarchy<Weight>::RemoveArc(std::vector<Arc> &arcs, VertexId vertex) {
+    auto it = std::find_if(arcs.begin(), arcs.end(), [vertex](const Arc &arc) { return arc.vertex == vertex; });
+    if (it != arcs.end()) {
+      *it = arcs.back();
+      arcs.pop_back();
+    }
+  }
+
+  template<typename Weight>
+  template<typename AddShortcut>
+  void ContractionHierarchy<Weight>::ForEachNeededShortcut(VertexId vertex, size_t settle_limit,
+                                                           AddShortcut add_shortcut) {
+    for (const Arc &in_arc: in_arcs_[vertex]) {
+      const VertexId source = in_arc.vertex;
+      std::optional<Weight> max_weight;
+      for (const Arc &out_arc: out_arcs_[vertex]) {
+        if (out_arc.vertex != source) {
+          max_weight = std::max(max_weight.value_or(ZERO_WEIGHT), in_arc.weight + out_arc.weight);
+        }
+      }
+      if (!max_weight) {
+        continue;
+      }
+
+      // Ограниченный поиск Дейкстры от source в обход сжимаемой вершины
+      for (const VertexId touched: witness_touched_) {
+        witness_weights_[touched] = INFINITE_WEIGHT;
+      }
+      witness_touched_.clear();
+      Queue queue;
+      witness_weights_[source] = ZERO_WEIGHT;
+      witness_touched_.push_back(source);
+      queue.push({ZERO_WEIGHT, source});
+      size_t settled_count = 0;
+      while (!queue.empty() && settled_count < settle_limit) {
+        const auto [weight, current] = queue.top();
+        queue.pop();
+        if (witness_weights_[current] < weight) {
+          continue;
+        }
+        if (*max_weight < weight) {
+          break;
+        }
+        ++settled_count;
+        for (const Arc &arc: out_arcs_[current]) {
+          if (arc.vertex == vertex) {
+            continue;
+          }
+          const Weight candidate_weight = weight + arc.weight;
+          if (candidate_weight < witness_weights_[arc.vertex]) {
+            if (witness_weights_[arc.vertex] == INFINITE_WEIGHT) {
+              witness_touched_.push_back(arc.vertex);
+            }
+            witness_weights_[arc.vertex] = candidate_weight;
+            queue.push({candidate_weight, arc.vertex});
+          }
+        }
+      }
+
+      for (const Arc &out_arc: out_arcs_[vertex]) {
+        const VertexId target = out_arc.vertex;
+        if (target == source) {
+          continue;
+        }
+        const Weight via_weight = in_arc.weight + out_arc.weight;
+        if (via_weight < witness_weights_[target]) {
+          add_shortcut(in_arc, out_arc, via_weight);
+        }
+      }
+    }
+  }
+
+  template<typename Weight>
+  int ContractionHierarchy<Weight>::ComputePriority(VertexId vertex) {
+    int shortcuts_count = 0;
+    // Для оценки приоритета достаточно более грубого поиска свидетелей
+    ForEachNeededShortcut(vertex, std::max<size_t>(witness_settle_limit_ / 10, 1),
+                          [&shortcuts_count](const Arc &, const Arc &, Weight) {
+                            ++shortcuts_count;
+                          });
+    const int removed_count = static_cast<int>(in_arcs_[vertex].size() + out_arcs_[vertex].size());
+    return shortcuts_count - removed_count + contracted_neighbors_[vertex];
+  }
+
+  template<typename Weight>
+  void ContractionHierarchy<Weight>::Contract() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const size_t edge_count = graph_.GetEdgeCount();
+
+    using PriorityItem = std::pair<int, VertexId>;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<>> order;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      order.push({ComputePriority(vertex), vertex});
+    }
+
+    struct NewShortcut {
+      VertexId from;
+      VertexId to;
+      Weight weight;
+      Shortcut shortcut;
+    };
+    std::vector<NewShortcut> new_shortcuts;
+    upward_arcs_.assign(vertex_count, {});
+    downward_arcs_.assign(vertex_count, {});
+    size_t next_rank = 0;
+    while (!order.empty()) {
+      const auto [priority, vertex] = order.top();
+      order.pop();
+      if (contracted_[vertex]) {
+        continue;
+      }
+      // Ленивое обновление: приоритет мог вырасти после сжатия соседей
+      const int actual_priority = ComputePriority(vertex);
+      if (!order.empty() && actual_priority > order.top().first) {
+        order.push({actual_priority, vertex});
+        continue;
+      }
+
+      new_shortcuts.clear();
+      ForEachNeededShortcut(vertex, witness_settle_limit_, [&new_shortcuts](const Arc &in_arc, const Arc &out_arc,
+                                                                           Weight weight) {
+        new_shortcuts.push_back({in_arc.vertex, out_arc.vertex, weight, {in_arc.arc_id, out_arc.arc_id}});
+      });
+      for (const auto &new_shortcut: new_shortcuts) {
+        shortcuts_.push_back(new_shortcut.shortcut);
+        AddArc(new_shortcut.from, new_shortcut.to, new_shortcut.weight, edge_count + shortcuts_.size() - 1);
+      }
+
+      // Все оставшиеся соседи получат больший ранг: дуги вершины переходят в граф поиска
+      // и удаляются из рабочего графа
+      contracted_[vertex] = true;
+      ranks_[vertex] = next_rank++;
+      for (const Arc &arc: out_arcs_[vertex]) {
+        upward_arcs_[vertex].push_back({arc.vertex, arc.weight, arc.arc_id});
+        ++contracted_neighbors_[arc.vertex];
+        RemoveArc(in_arcs_[arc.vertex], vertex);
+      }
+      for (const Arc &arc: in_arcs_[vertex]) {
+        downward_arcs_[vertex].push_back({arc.vertex, arc.weight, arc.arc_id});
+        ++contracted_neighbors_[arc.vertex];
+        RemoveArc(out_arcs_[arc.vertex], vertex);
+      }
+      out_arcs_[vertex].clear();
+      in_arcs_[vertex].clear();
+    }
+
+    out_arcs_.clear();
+    in_arcs_.clear();
+    contracted_.clear();
+    contracted_neighbors_.clear();
+    witness_weights_.clear();
+    witness_touched_.clear();
+  }
+
+  template<typename Weight>
+  void ContractionHierarchy<Weight>::UnpackArc(ArcId arc_id, std::vector<EdgeId> &edges) const {
+    const size_t edge_count = graph_.GetEdgeCount();
+    std::vector<ArcId> stack = {arc_id};
+    while (!stack.empty()) {
+      const ArcId current = stack.back();
+      stack.pop_back();
+      if (current < edge_count) {
+        edges.push_back(current);
+      } else {
+        const Shortcut &shortcut = shortcuts_[current - edge_count];
+        stack.push_back(shortcut.second);
+        stack.push_back(shortcut.first);
+      }
+    }
+  }
+
+  template<typename Weight>
+  std::optional<typename ContractionHierarchy<Weight>::RouteInfo>
+  ContractionHierarchy<Weight>::BuildRoute(VertexId from, VertexId to, SearchStats *stats) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+      throw std::out_of_range("Vertex id is out of range");
+    }
+
+    struct SearchState {
+      std::vector<Weight> weights;
+      std::vector<ArcId> prev_arcs;
+      std::vector<VertexId> prev_vertices;
+      Queue queue;
+    };
+    SearchState forward{std::vector<Weight>(vertex_count, INFINITE_WEIGHT),
+                        std::vector<ArcId>(vertex_count, NO_ARC),
+                        std::vector<VertexId>(vertex_count, 0), {}};
+    SearchState backward = forward;
+    forward.weights[from] = ZERO_WEIGHT;
+    forward.queue.push({ZERO_WEIGHT, from});
+    backward.weights[to] = ZERO_WEIGHT;
+    backward.queue.push({ZERO_WEIGHT, to});
+
+    Weight best_weight = INFINITE_WEIGHT;
+    VertexId meeting_vertex = from;
+    if (from == to) {
+      best_weight = ZERO_WEIGHT;
+    }
+    size_t settled_count = 0;
+
+    // stall_arcs - дуги противоположного направления: если через них вершина достижима
+    // быстрее, её не нужно раскрывать (stall-on-demand)
+    auto step = [&best_weight, &meeting_vertex, &settled_count](SearchState &state, const SearchState &other,
+                                                                const std::vector<std::vector<SearchArc>> &arcs,
+                                                                const std::vector<std::vector<SearchArc>> &stall_arcs) {
+      const auto [weight, vertex] = state.queue.top();
+      state.queue.pop();
+      if (state.weights[vertex] < weight) {
+        return;
+      }
+      ++settled_count;
+      for (const SearchArc &arc: stall_arcs[vertex]) {
+        if (state.weights[arc.vertex] + arc.weight < weight) {
+          return;
+        }
+      }
+      for (const SearchArc &arc: arcs[vertex]) {
+        const Weight candidate_weight = weight + arc.weight;
+        if (candidate_weight < state.weights[arc.vertex]) {
+          state.weights[arc.vertex] = candidate_weight;
+          state.prev_arcs[arc.vertex] = arc.arc_id;
+          state.prev_vertices[arc.vertex] = vertex;
+          state.queue.push({candidate_weight, arc.vertex});
+          if (other.weights[arc.vertex] < INFINITE_WEIGHT
+              && candidate_weight + other.weights[arc.vertex] < best_weight) {
+            best_weight = candidate_weight + other.weights[arc.vertex];
+            meeting_vertex = arc.vertex;
+          }
+        }
+      }
+    };
+
+    // Направление останавливается, когда его минимум не меньше лучшего найденного пути
+    while (true) {
+      const bool forward_active = !forward.queue.empty() && forward.queue.top().first < best_weight;
+      const bool backward_active = !backward.queue.empty() && backward.queue.top().first < best_weight;
+      if (!forward_active && !backward_active) {
+        break;
+      }
+      if (forward_active && (!backward_active || forward.queue.top().first <= backward.queue.top().first)) {
+        step(forward, backward, upward_arcs_, downward_arcs_);
+      } else {
+        step(backward, forward, downward_arcs_, upward_arcs_);
+      }
+    }
+    if (stats) {
+      stats->settled_vertices = settled_count;
+    }
+
+    if (!(best_weight < INFINITE_WEIGHT)) {
+      return std::nullopt;
+    }
+
+    std::vector<ArcId> forward_arcs;
+    for (VertexId vertex = meeting_vertex; vertex != from; vertex = forward.prev_vertices[vertex]) {
+      forward_arcs.push_back(forward.prev_arcs[vertex]);
+    }
+    std::reverse(forward_arcs.begin(), forward_arcs.end());
+    std::vector<EdgeId> edges;
+    for (const ArcId arc_id: forward_arcs) {
+      UnpackArc(arc_id, edges);
+    }
+    for (VertexId vertex = meeting_vertex; vertex != to; vertex = backward.prev_vertices[vertex]) {
+      UnpackArc(backward.prev_arcs[vertex], edges);
+    }
+
+    return RouteInfo{best_weight, std::move(edges)};
+  }
+
+  template<typename Weight>
+  std::vector<std::pair<VertexId, Weight>>
+  ContractionHierarchy<Weight>::SearchUpward(VertexId start, const std::vector<std::vector<SearchArc>> &arcs,
+                                             const std::vector<std::vector<SearchArc>> &stall_arcs) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (start >= vertex_count) {
+      throw std::out_of_range("Vertex id is out of range");
+    }
+    // Пространство поиска вверх мало, поэтому веса хранятся в хеш-таблице, а не в векторе на весь граф
+    std::unordered_map<VertexId, Weight> weights;
+    std::unordered_set<VertexId> settled;
+    std::vector<std::pair<VertexId, Weight>> result;
+    Queue queue;
+    weights[start] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, start});
+    while (!queue.empty()) {
+      const auto [weight, vertex] = queue.top();
+      queue.pop();
+      if (!settled.insert(vertex).second) {
+        continue;
+      }
+      bool is_stalled = false;
+      for (const SearchArc &arc: stall_arcs[vertex]) {
+        const auto it = weights.find(arc.vertex);
+        if (it != weights.end() && it->second + arc.weight < weight) {
+          is_stalled = true;
+          break;
+        }
+      }
+      if (is_stalled) {
+        continue;
+      }
+      result.push_back({vertex, weight});
+      for (const SearchArc &arc: arcs[vertex]) {
+        const Weight candidate_weight = weight + arc.weight;
+        const auto [it, inserted] = weights.emplace(arc.vertex, candidate_weight);
+        if (inserted || candidate_weight < it->second) {
+          it->second = candidate_weight;
+          queue.push({candidate_weight, arc.vertex});
+        }
+      }
+    }
+    return result;
+  }
+
+  template<typename Weight>
+  std::vector<std::vector<std::optional<Weight>>>
+  ContractionHierarchy<Weight>::BuildWeightsMatrix(const std::vector<VertexId> &sources,
+                                                   const std::vector<VertexId> &targets,
+                                                   size_t threads_count) const {
+    struct BucketEntry {
+      size_t target_index;
+      Weight weight;
+    };
+
+    std::vector<std::vector<std::pair<VertexId, Weight>>> target_spaces(targets.size());
+    parallel::ForEachIndex(targets.size(), threads_count, [&](size_t target_index) {
+      target_spaces[target_index] = SearchUpward(targets[target_index], downward_arcs_, upward_arcs_);
+    });
+    std::vector<std::vector<BucketEntry>> buckets(graph_.GetVertexCount());
+    for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+      for (const auto &[vertex, weight]: target_spaces[target_index]) {
+        buckets[vertex].push_back({target_index, weight});
+      }
+    }
+    target_spaces.clear();
+
+    std::vector<std::vector<std::optional<Weight>>> result(sources.size());
+    parallel::ForEachIndex(sources.size(), threads_count, [&](size_t source_index) {
+      std::vector<Weight> row(targets.size(), INFINITE_WEIGHT);
+      for (const auto &[vertex, weight]: SearchUpward(sources[source_index], upward_arcs_, downward_arcs_)) {
+        for (const BucketEntry &entry: buckets[vertex]) {
+          row[entry.target_index] = std::min(row[entry.target_index], weight + entry.weight);
+        }
+      }
+      auto &result_row = result[source_index];
+      result_row.reserve(targets.size());
+      for (const Weight weight: row) {
+        result_row.push_back(weight < INFINITE_WEIGHT ? std::optional<Weight>{weight} : std::nullopt);
+      }
+    });
+    return result;
+  }
+
+} // namespace graph
@@ -2,10 +2,12 @@
 
 #include <string>
 #include <set>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 #include <cstdint>
 #include "geo.h"
+#include "ranges.h"
 
 namespace transport_catalogue {
 
@@ -15,16 +17,33 @@ namespace transport_catalogue {
     bool is_roundtrip;
   };
 
+  struct InputStopData {
+    std::string name;
+    geo::Coordinates coordinates;
+    // Расстояния до соседних остановок по их названиям в порядке описания
+    std::vector<std::pair<std::string, int64_t>> stops_to_dists;
+  };
+
   struct Stop {
     std::string name;
     geo::Coordinates coordinates;
-    std::unordered_map <std::string, int64_t> stops_to_dists;
+    // Плотный номер остановки, назначается справочником при добавлении
+    uint32_t id = 0;
   };
 
   struct Bus {
     std::string name;
     std::vector<Stop *> stops;
     bool is_roundtrip;
+    // Плотный номер маршрута, назначается справочником при добавлении
+    uint32_t id = 0;
+  };
+
+  // Дорожное расстояние между остановками, заданными идентификаторами
+  struct StopsDistance {
+    size_t from;
+    size_t to;
+    int64_t distance;
   };
 
   struct BusInfo {
@@ -32,9 +51,12 @@ namespace transport_catalogue {
     size_t numb_of_unique_stops;
     double length;
     int64_t true_length;
+    // Отношение дорожной длины к географической
+    double curvature;
   };
 
   struct StopInfo {
-    std::set <std::string_view> passing_buses;
+    // Номера маршрутов через остановку в алфавитном порядке названий, без копирования
+    ranges::Range<std::vector<uint32_t>::const_iterator> passing_buses;
   };
 }
\ No newline at end of file
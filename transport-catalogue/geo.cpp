@@ -1,10 +1,89 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GEO_HAS_AVX2_KERNEL
+#endif
 
 namespace geo {
 
+namespace {
+
+// Косинус угла между точками по формуле cos(a - b) = cos a cos b + sin a sin b
+double ComputeCosine(const PreparedCoordinates& from, const PreparedCoordinates& to) {
+    const double cos_lng = from.cos_lng * to.cos_lng + from.sin_lng * to.sin_lng;
+    return from.sin_lat * to.sin_lat + from.cos_lat * to.cos_lat * cos_lng;
+}
+
+// Расстояние по косинусу угла. Совпадающие точки дают 0, как в ComputeDistance,
+// а косинус, вышедший из-за округления за 1, - расстояние 0, а не NaN.
+double ComputeDistanceFromCosine(const PreparedCoordinates& from, const PreparedCoordinates& to, double cosine) {
+    if (from == to) {
+        return 0;
+    }
+    return std::acos(std::clamp(cosine, -1., 1.)) * EARTH_RADIUS;
+}
+
+void ComputeCosines(const PreparedCoordinates* from, const PreparedCoordinates* to, double* cosines,
+                    size_t count) {
+    for (size_t index = 0; index < count; ++index) {
+        cosines[index] = ComputeCosine(from[index], to[index]);
+    }
+}
+
+#ifdef GEO_HAS_AVX2_KERNEL
+// Четыре структуры по 32 байта - это четыре регистра, после транспонирования в каждом
+// регистре одно поле для четырёх точек
+__attribute__((target("avx2"))) void LoadFieldsAvx2(const PreparedCoordinates* points, __m256d (&fields)[4]) {
+    static_assert(sizeof(PreparedCoordinates) == 4 * sizeof(double));
+    const __m256d p0 = _mm256_loadu_pd(&points[0].sin_lat);
+    const __m256d p1 = _mm256_loadu_pd(&points[1].sin_lat);
+    const __m256d p2 = _mm256_loadu_pd(&points[2].sin_lat);
+    const __m256d p3 = _mm256_loadu_pd(&points[3].sin_lat);
+    const __m256d low01 = _mm256_unpacklo_pd(p0, p1);
+    const __m256d high01 = _mm256_unpackhi_pd(p0, p1);
+    const __m256d low23 = _mm256_unpacklo_pd(p2, p3);
+    const __m256d high23 = _mm256_unpackhi_pd(p2, p3);
+    fields[0] = _mm256_permute2f128_pd(low01, low23, 0x20);
+    fields[1] = _mm256_permute2f128_pd(high01, high23, 0x20);
+    fields[2] = _mm256_permute2f128_pd(low01, low23, 0x31);
+    fields[3] = _mm256_permute2f128_pd(high01, high23, 0x31);
+}
+
+// Порядок операций тот же, что в ComputeCosine, без FMA, поэтому результат совпадает со скалярным
+__attribute__((target("avx2"))) void ComputeCosinesAvx2(const PreparedCoordinates* from,
+                                                        const PreparedCoordinates* to, double* cosines,
+                                                        size_t count) {
+    size_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+        __m256d a[4];
+        __m256d b[4];
+        LoadFieldsAvx2(from + index, a);
+        LoadFieldsAvx2(to + index, b);
+        const __m256d cos_lng = _mm256_add_pd(_mm256_mul_pd(a[3], b[3]), _mm256_mul_pd(a[2], b[2]));
+        const __m256d cosine = _mm256_add_pd(_mm256_mul_pd(a[0], b[0]),
+                                             _mm256_mul_pd(_mm256_mul_pd(a[1], b[1]), cos_lng));
+        _mm256_storeu_pd(cosines + index, cosine);
+    }
+    // Компилятор не всегда сбрасывает верхние половины регистров перед переходом
+    // в обычный код, а без этого замедляются все следующие SSE-вычисления, включая acos
+    _mm256_zeroupper();
+    ComputeCosines(from + index, to + index, cosines + index, count - index);
+}
+
+bool HasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+#endif
+
+}  // namespace
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
     if (from == to) {
@@ -13,7 +92,52 @@ double ComputeDistance(Coordinates from, Coordinates to) {
     static const double dr = M_PI / 180.;
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+        * EARTH_RADIUS;
+}
+
+PreparedCoordinates PrepareCoordinates(Coordinates point) {
+    static const double dr = M_PI / 180.;
+    return {std::sin(point.lat * dr), std::cos(point.lat * dr), std::sin(point.lng * dr), std::cos(point.lng * dr)};
+}
+
+double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to) {
+    return ComputeDistanceFromCosine(from, to, ComputeCosine(from, to));
+}
+
+bool IsDistanceKernelSupported(DistanceKernel kernel) {
+    switch (kernel) {
+        case DistanceKernel::AVX2:
+#ifdef GEO_HAS_AVX2_KERNEL
+            return HasAvx2();
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+void ComputeDistances(const PreparedCoordinates* from, const PreparedCoordinates* to, double* distances,
+                      size_t count, DistanceKernel kernel) {
+    if (!IsDistanceKernelSupported(kernel)) {
+        throw std::invalid_argument("Distance kernel is not supported");
+    }
+    if (kernel == DistanceKernel::AUTO) {
+        kernel = IsDistanceKernelSupported(DistanceKernel::AVX2) ? DistanceKernel::AVX2 : DistanceKernel::SCALAR;
+    }
+#ifdef GEO_HAS_AVX2_KERNEL
+    if (kernel == DistanceKernel::AVX2) {
+        ComputeCosinesAvx2(from, to, distances, count);
+    } else {
+        ComputeCosines(from, to, distances, count);
+    }
+#else
+    ComputeCosines(from, to, distances, count);
+#endif
+    // acos не векторизуется, поэтому считается отдельным проходом по готовым косинусам
+    for (size_t index = 0; index < count; ++index) {
+        distances[index] = ComputeDistanceFromCosine(from[index], to[index], distances[index]);
+    }
 }
 
-}  // namespace geo
\ No newline at end of file
+}  // namespace geo
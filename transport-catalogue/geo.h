@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstddef>
+
 namespace geo {
 
+inline constexpr double EARTH_RADIUS = 6371000;
+
 struct Coordinates {
     double lat; // Широта
     double lng; // Долгота
@@ -15,4 +19,40 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
-}  // namespace geo
\ No newline at end of file
+// Синусы и косинусы широты и долготы точки. Считаются один раз на точку, после чего
+// расстояние требует только умножений, сложений и одного acos.
+struct PreparedCoordinates {
+    double sin_lat;
+    double cos_lat;
+    double sin_lng;
+    double cos_lng;
+    bool operator==(const PreparedCoordinates& other) const {
+        return sin_lat == other.sin_lat && cos_lat == other.cos_lat
+            && sin_lng == other.sin_lng && cos_lng == other.cos_lng;
+    }
+};
+
+PreparedCoordinates PrepareCoordinates(Coordinates point);
+
+// Та же формула, что в ComputeDistance, с косинусом разности долгот через косинусы
+// и синусы самих долгот. Отличие от ComputeDistance - только в округлении.
+double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to);
+
+// Реализация пакетного расчёта расстояний
+enum class DistanceKernel {
+    // AVX2, если его поддерживает процессор, иначе SCALAR
+    AUTO,
+    SCALAR,
+    AVX2,
+};
+
+bool IsDistanceKernelSupported(DistanceKernel kernel);
+
+// distances[i] - расстояние между from[i] и to[i], i < count. Ядро AVX2 считает аргумент acos
+// для четырёх пар за раз в том же порядке операций, поэтому без сжатия умножений и сложений
+// в FMA результат совпадает с ComputeDistance для PreparedCoordinates до бита.
+// Для неподдерживаемого ядра бросает std::invalid_argument.
+void ComputeDistances(const PreparedCoordinates* from, const PreparedCoordinates* to, double* distances,
+                      size_t count, DistanceKernel kernel = DistanceKernel::AUTO);
+
+}  // namespace geo
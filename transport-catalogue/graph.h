@@ -1,7 +1,12 @@
 #pragma once
 
 #include "ranges.h"
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace graph {
@@ -9,72 +14,278 @@ namespace graph {
   using VertexId = size_t;
   using EdgeId = size_t;
 
+  inline constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
   template<typename Weight>
   struct Edge {
     VertexId from;
     VertexId to;
     Weight weight;
-    std::string bus_name;
+    uint32_t bus_id;
     int span_count;
   };
 
+  // Граф в формате CSR: рёбра каждой вершины лежат подряд, а концы, веса и прочие
+  // данные рёбер хранятся в отдельных массивах. Рёбра не добавляются по одному:
+  // граф собирается GraphBuilder и меняется только пакетами через ReplaceEdges.
   template<typename Weight>
   class DirectedWeightedGraph {
   private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidentEdgesRange = decltype(ranges::AsIndexRange(EdgeId{}, EdgeId{}));
 
   public:
+    struct EdgePayload {
+      uint32_t bus_id;
+      int span_count;
+    };
+
+    // Массивы CSR целиком: позволяют сохранить граф и восстановить его без перестроения
+    struct Arrays {
+      std::vector<EdgeId> offsets;
+      std::vector<VertexId> targets;
+      std::vector<Weight> weights;
+      std::vector<EdgePayload> payloads;
+    };
+
     DirectedWeightedGraph() = default;
 
     explicit DirectedWeightedGraph(size_t vertex_count);
 
-    EdgeId AddEdge(const Edge<Weight> &edge);
+    explicit DirectedWeightedGraph(Arrays arrays);
+
+    Arrays GetArrays() const;
 
     size_t GetVertexCount() const;
 
     size_t GetEdgeCount() const;
 
-    const Edge<Weight> &GetEdge(EdgeId edge_id) const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
+
+    VertexId GetEdgeSource(EdgeId edge_id) const;
+
+    VertexId GetEdgeTarget(EdgeId edge_id) const;
+
+    Weight GetEdgeWeight(EdgeId edge_id) const;
 
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // Меняет вес ребра на месте, идентификаторы рёбер сохраняются
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
+
+    // Удаляет рёбра removed_edges и добавляет added_edges за один проход по массивам.
+    // Оставшиеся рёбра сохраняют взаимный порядок, добавленные встают в конец рёбер своей
+    // вершины в порядке перечисления. Возвращает новый идентификатор каждого старого ребра
+    // (NO_EDGE для удалённых), added_edge_ids, если задан, получает идентификаторы добавленных.
+    std::vector<EdgeId> ReplaceEdges(const std::vector<EdgeId> &removed_edges,
+                                     const std::vector<Edge<Weight>> &added_edges,
+                                     std::vector<EdgeId> *added_edge_ids = nullptr);
+
   private:
-    std::vector <Edge<Weight>> edges_;
-    std::vector <IncidenceList> incidence_lists_;
+    template<typename>
+    friend class GraphBuilder;
+
+    // offsets_[v]..offsets_[v + 1] - идентификаторы рёбер, выходящих из v
+    std::vector<EdgeId> offsets_ = {0};
+    std::vector<VertexId> targets_;
+    std::vector<Weight> weights_;
+    std::vector<EdgePayload> payloads_;
+  };
+
+  // Накапливает рёбра и за один проход раскладывает их в CSR.
+  // Рёбра одной вершины сохраняют порядок добавления.
+  template<typename Weight>
+  class GraphBuilder {
+  public:
+    explicit GraphBuilder(size_t vertex_count);
+
+    void AddEdge(const Edge<Weight> &edge);
+
+    // edge_ids, если задан, получает идентификатор каждого ребра в порядке добавления
+    DirectedWeightedGraph<Weight> Build(std::vector<EdgeId> *edge_ids = nullptr);
+
+  private:
+    std::vector<Edge<Weight>> edges_;
+    std::vector<size_t> out_degrees_;
   };
 
   template<typename Weight>
   DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-      : incidence_lists_(vertex_count) {
+      : offsets_(vertex_count + 1, 0) {
   }
 
   template<typename Weight>
-  EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight> &edge) {
-    edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+  DirectedWeightedGraph<Weight>::DirectedWeightedGraph(Arrays arrays)
+      : offsets_(std::move(arrays.offsets)), targets_(std::move(arrays.targets)),
+        weights_(std::move(arrays.weights)), payloads_(std::move(arrays.payloads)) {
+    const size_t edge_count = targets_.size();
+    if (offsets_.empty() || offsets_.front() != 0 || offsets_.back() != edge_count
+        || !std::is_sorted(offsets_.begin(), offsets_.end())
+        || weights_.size() != edge_count || payloads_.size() != edge_count) {
+      throw std::invalid_argument("Inconsistent graph arrays");
+    }
+    const size_t vertex_count = offsets_.size() - 1;
+    if (std::any_of(targets_.begin(), targets_.end(), [vertex_count](VertexId target) {
+      return target >= vertex_count;
+    })) {
+      throw std::invalid_argument("Edge target is out of range");
+    }
+  }
+
+  template<typename Weight>
+  typename DirectedWeightedGraph<Weight>::Arrays DirectedWeightedGraph<Weight>::GetArrays() const {
+    return {offsets_, targets_, weights_, payloads_};
   }
 
   template<typename Weight>
   size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return offsets_.size() - 1;
   }
 
   template<typename Weight>
   size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+    return targets_.size();
+  }
+
+  template<typename Weight>
+  Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    const auto &payload = payloads_.at(edge_id);
+    return {GetEdgeSource(edge_id), targets_[edge_id], weights_[edge_id], payload.bus_id, payload.span_count};
   }
 
   template<typename Weight>
-  const Edge<Weight> &DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-    return edges_.at(edge_id);
+  VertexId DirectedWeightedGraph<Weight>::GetEdgeSource(EdgeId edge_id) const {
+    if (edge_id >= GetEdgeCount()) {
+      throw std::out_of_range("Edge id is out of range");
+    }
+    const auto it = std::upper_bound(offsets_.begin(), offsets_.end(), edge_id);
+    return static_cast<VertexId>(it - offsets_.begin()) - 1;
+  }
+
+  template<typename Weight>
+  VertexId DirectedWeightedGraph<Weight>::GetEdgeTarget(EdgeId edge_id) const {
+    return targets_[edge_id];
+  }
+
+  template<typename Weight>
+  Weight DirectedWeightedGraph<Weight>::GetEdgeWeight(EdgeId edge_id) const {
+    return weights_[edge_id];
   }
 
   template<typename Weight>
   typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
   DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    return ranges::AsIndexRange(offsets_.at(vertex), offsets_.at(vertex + 1));
+  }
+
+  template<typename Weight>
+  void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    weights_.at(edge_id) = weight;
+  }
+
+  template<typename Weight>
+  std::vector<EdgeId> DirectedWeightedGraph<Weight>::ReplaceEdges(const std::vector<EdgeId> &removed_edges,
+                                                                 const std::vector<Edge<Weight>> &added_edges,
+                                                                 std::vector<EdgeId> *added_edge_ids) {
+    const size_t vertex_count = GetVertexCount();
+    const size_t edge_count = GetEdgeCount();
+    std::vector<EdgeId> new_edge_ids(edge_count, 0);
+    for (const EdgeId edge_id: removed_edges) {
+      new_edge_ids.at(edge_id) = NO_EDGE;
+    }
+    // Степени вершин после замены: оставшиеся рёбра плюс добавленные
+    std::vector<EdgeId> new_offsets(vertex_count + 1, 0);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      for (EdgeId edge_id = offsets_[vertex]; edge_id < offsets_[vertex + 1]; ++edge_id) {
+        new_offsets[vertex + 1] += new_edge_ids[edge_id] != NO_EDGE;
+      }
+    }
+    for (const auto &edge: added_edges) {
+      if (edge.from >= vertex_count || edge.to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+      }
+      ++new_offsets[edge.from + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      new_offsets[vertex + 1] += new_offsets[vertex];
+    }
+
+    const size_t new_edge_count = new_offsets.back();
+    std::vector<VertexId> new_targets(new_edge_count);
+    std::vector<Weight> new_weights(new_edge_count);
+    std::vector<EdgePayload> new_payloads(new_edge_count);
+    // Позиция, куда ляжет следующее ребро каждой вершины
+    std::vector<EdgeId> positions(new_offsets.begin(), new_offsets.end() - 1);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      for (EdgeId edge_id = offsets_[vertex]; edge_id < offsets_[vertex + 1]; ++edge_id) {
+        if (new_edge_ids[edge_id] == NO_EDGE) {
+          continue;
+        }
+        const EdgeId id = positions[vertex]++;
+        new_edge_ids[edge_id] = id;
+        new_targets[id] = targets_[edge_id];
+        new_weights[id] = weights_[edge_id];
+        new_payloads[id] = payloads_[edge_id];
+      }
+    }
+    if (added_edge_ids) {
+      added_edge_ids->clear();
+      added_edge_ids->reserve(added_edges.size());
+    }
+    for (const auto &edge: added_edges) {
+      const EdgeId id = positions[edge.from]++;
+      if (added_edge_ids) {
+        added_edge_ids->push_back(id);
+      }
+      new_targets[id] = edge.to;
+      new_weights[id] = edge.weight;
+      new_payloads[id] = {edge.bus_id, edge.span_count};
+    }
+
+    offsets_ = std::move(new_offsets);
+    targets_ = std::move(new_targets);
+    weights_ = std::move(new_weights);
+    payloads_ = std::move(new_payloads);
+    return new_edge_ids;
+  }
+
+  template<typename Weight>
+  GraphBuilder<Weight>::GraphBuilder(size_t vertex_count)
+      : out_degrees_(vertex_count, 0) {
+  }
+
+  template<typename Weight>
+  void GraphBuilder<Weight>::AddEdge(const Edge<Weight> &edge) {
+    ++out_degrees_.at(edge.from);
+    edges_.push_back(edge);
+  }
+
+  template<typename Weight>
+  DirectedWeightedGraph<Weight> GraphBuilder<Weight>::Build(std::vector<EdgeId> *edge_ids) {
+    DirectedWeightedGraph<Weight> result(out_degrees_.size());
+    for (VertexId vertex = 0; vertex < out_degrees_.size(); ++vertex) {
+      result.offsets_[vertex + 1] = result.offsets_[vertex] + out_degrees_[vertex];
+    }
+    result.targets_.resize(edges_.size());
+    result.weights_.resize(edges_.size());
+    result.payloads_.resize(edges_.size());
+
+    // Позиция, куда ляжет следующее ребро каждой вершины
+    std::vector<EdgeId> positions(result.offsets_.begin(), result.offsets_.end() - 1);
+    if (edge_ids) {
+      edge_ids->clear();
+      edge_ids->reserve(edges_.size());
+    }
+    for (const auto &edge: edges_) {
+      const EdgeId id = positions[edge.from]++;
+      if (edge_ids) {
+        edge_ids->push_back(id);
+      }
+      result.targets_[id] = edge.to;
+      result.weights_[id] = edge.weight;
+      result.payloads_[id] = {edge.bus_id, edge.span_count};
+    }
+    edges_.clear();
+    std::fill(out_degrees_.begin(), out_degrees_.end(), 0);
+    return result;
   }
-} // namespace graph
\ No newline at end of file
+} // namespace graph
@@ -1,9 +1,45 @@
 #include "json.h"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
+#include <string_view>
 
 using namespace std;
 
 namespace json {
+  namespace {
+    constexpr uint64_t BYTE_ONES = 0x0101010101010101ULL;
+    constexpr uint64_t BYTE_HIGH_BITS = 0x8080808080808080ULL;
+
+    // Ненулевое значение, если среди восьми байтов word есть байт c
+    uint64_t HasByte(uint64_t word, char c) {
+      const uint64_t diff = word ^ (BYTE_ONES * static_cast<unsigned char>(c));
+      return (diff - BYTE_ONES) & ~diff & BYTE_HIGH_BITS;
+    }
+
+    bool IsStringSpecial(char c) {
+      return c == '"' || c == '\\' || c == '\n' || c == '\r';
+    }
+
+    // Позиция первого особого для строки символа, начиная с pos, или размер текста.
+    // Текст просматривается по восемь байтов за раз, остаток - побайтово.
+    size_t FindStringSpecial(std::string_view text, size_t pos) {
+      while (text.size() - pos >= sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, text.data() + pos, sizeof(word));
+        if (HasByte(word, '"') | HasByte(word, '\\') | HasByte(word, '\n') | HasByte(word, '\r')) {
+          break;
+        }
+        pos += sizeof(word);
+      }
+      while (pos < text.size() && !IsStringSpecial(text[pos])) {
+        ++pos;
+      }
+      return pos;
+    }
+  }
+
   bool Node::IsInt() const {
     return std::holds_alternative<int>(value_);
   }
@@ -36,234 +72,257 @@ namespace json {
     return std::holds_alternative<Dict>(value_);
   }
 
-  namespace {
+  Node Reader::ReadNode() {
+    SkipSpaces();
+    if (pos_ == text_.size()) {
+      throw json::ParsingError("Unexpected end of input"s);
+    }
+    const char c = text_[pos_];
+    switch (c) {
+      case '[':
+        ++pos_;
+        return LoadArray();
+      case '{':
+        ++pos_;
+        return LoadDict();
+      case '"':
+        ++pos_;
+        return Node(LoadString());
+      case 'n':
+        LoadLiteral("null"sv, "Bad data for null"s);
+        return Node();
+      case 't':
+        LoadLiteral("true"sv, "Bad data bool"s);
+        return Node(true);
+      case 'f':
+        LoadLiteral("false"sv, "Bad data bool"s);
+        return Node(false);
+      case ']':
+        throw json::ParsingError("Bad data for array"s);
+      case '}':
+        throw json::ParsingError("Bad data for dictionary"s);
+      default:
+        return LoadNumber();
+    }
+  }
 
-    Node LoadNode(istream &input);
+  std::string Reader::ReadString() {
+    Expect('"', "String expected");
+    return LoadString();
+  }
 
-    Node LoadArray(istream &input) {
-      Array result;
-      char c;
-      for (; input >> c && c != ']';) {
-        if (c != ',') {
-          input.putback(c);
-        }
-        result.push_back(LoadNode(input));
-      }
-      if (c != ']') {
-        throw json::ParsingError("Bad data for array");
-      }
+  int Reader::ReadInt() {
+    SkipSpaces();
+    return LoadNumber().AsInt();
+  }
+
+  double Reader::ReadDouble() {
+    SkipSpaces();
+    return LoadNumber().AsDouble();
+  }
 
-      return Node(move(result));
+  bool Reader::ReadBool() {
+    const char c = PeekSignificant();
+    if (c == 't') {
+      LoadLiteral("true"sv, "Bad data bool"s);
+      return true;
     }
+    LoadLiteral("false"sv, "Bad data bool"s);
+    return false;
+  }
 
-    class ParsingError : public std::runtime_error {
-    public:
-      using runtime_error::runtime_error;
-    };
+  // Пробельные символы те же, что пропускает operator>>
+  bool Reader::IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+  }
 
-    using Number = std::variant<int, double>;
+  bool Reader::IsDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
 
-    Number LoadNumber(std::istream &input) {
-      using namespace std::literals;
+  void Reader::SkipSpaces() {
+    while (pos_ < text_.size() && IsSpace(text_[pos_])) {
+      ++pos_;
+    }
+  }
 
-      std::string parsed_num;
+  char Reader::PeekSignificant() {
+    SkipSpaces();
+    return pos_ < text_.size() ? text_[pos_] : '\0';
+  }
 
-      auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-          throw ParsingError("Failed to read number from stream"s);
-        }
-      };
+  void Reader::Expect(char c, const char *error) {
+    if (PeekSignificant() != c) {
+      throw json::ParsingError(error);
+    }
+    ++pos_;
+  }
 
-      auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-          throw ParsingError("A digit is expected"s);
-        }
-        while (std::isdigit(input.peek())) {
-          read_char();
-        }
-      };
+  bool Reader::NextKey(std::string &key) {
+    char c = PeekSignificant();
+    if (c == '}') {
+      ++pos_;
+      return false;
+    }
+    if (c == ',') {
+      ++pos_;
+      c = PeekSignificant();
+    }
+    if (c != '"') {
+      throw json::ParsingError("Bad data for dictionary"s);
+    }
+    ++pos_;
+    key = LoadString();
+    if (PeekSignificant() != ':') {
+      throw json::ParsingError("Bad data for dictionary"s);
+    }
+    ++pos_;
+    return true;
+  }
 
-      if (input.peek() == '-') {
-        read_char();
-      }
-      if (input.peek() == '0') {
-        read_char();
-      } else {
-        read_digits();
-      }
+  bool Reader::NextElement() {
+    char c = PeekSignificant();
+    if (c == ']') {
+      ++pos_;
+      return false;
+    }
+    if (c == ',') {
+      ++pos_;
+      c = PeekSignificant();
+    }
+    if (c == '\0') {
+      throw json::ParsingError("Bad data for array"s);
+    }
+    return true;
+  }
 
-      bool is_int = true;
-      if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
-      }
+  Node Reader::LoadArray() {
+    Array result;
+    while (NextElement()) {
+      result.push_back(ReadNode());
+    }
+    return Node(std::move(result));
+  }
 
-      if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-          read_char();
-        }
-        read_digits();
-        is_int = false;
-      }
+  Node Reader::LoadDict() {
+    Dict result;
+    std::string key;
+    while (NextKey(key)) {
+      // Ключи во входных данных обычно уже упорядочены, поэтому вставка идёт с подсказкой в конец
+      result.emplace_hint(result.end(), std::move(key), ReadNode());
+    }
+    return Node(std::move(result));
+  }
 
-      try {
-        if (is_int) {
-          try {
-            return std::stoi(parsed_num);
-          }
-          catch (...) {
-          }
-        }
-        return std::stod(parsed_num);
+  std::string Reader::LoadString() {
+    std::string s;
+    while (true) {
+      // Обычные символы копируются в строку одним куском до ближайшего особого символа
+      const size_t begin = pos_;
+      pos_ = FindStringSpecial(text_, pos_);
+      s.append(text_.data() + begin, pos_ - begin);
+      if (pos_ == text_.size()) {
+        // Текст закончился до того, как встретили закрывающую кавычку
+        throw json::ParsingError("String parsing error"s);
       }
-      catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+      const char ch = text_[pos_++];
+      if (ch == '"') {
+        return s;
       }
-    }
-
-    std::string LoadStringPars(std::istream &input) {
-      using namespace std::literals;
-
-      auto it = std::istreambuf_iterator<char>(input);
-      auto end = std::istreambuf_iterator<char>();
-      std::string s;
-      while (true) {
-        if (it == end) {
-          // Поток закончился до того, как встретили закрывающую кавычку?
-          throw json::ParsingError("String parsing error");
-        }
-        const char ch = *it;
-        if (ch == '"') {
-          // Встретили закрывающую кавычку
-          ++it;
+      if (ch != '\\') {
+        // Строковый литерал внутри JSON не может прерываться символами \r или \n
+        throw json::ParsingError("Unexpected end of line"s);
+      }
+      if (pos_ == text_.size()) {
+        // Текст завершился сразу после символа обратной косой черты
+        throw json::ParsingError("String parsing error"s);
+      }
+      // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
+      const char escaped_char = text_[pos_++];
+      switch (escaped_char) {
+        case 'n':
+          s.push_back('\n');
           break;
-        } else if (ch == '\\') {
-          // Встретили начало escape-последовательности
-          ++it;
-          if (it == end) {
-            // Поток завершился сразу после символа обратной косой черты
-            throw json::ParsingError("String parsing error");
-          }
-          const char escaped_char = *(it);
-          // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
-          switch (escaped_char) {
-            case 'n':
-              s.push_back('\n');
-              break;
-            case 't':
-              s.push_back('\t');
-              break;
-            case 'r':
-              s.push_back('\r');
-              break;
-            case '"':
-              s.push_back('"');
-              break;
-            case '\\':
-              s.push_back('\\');
-              break;
-            default:
-              // Встретили неизвестную escape-последовательность
-              throw json::ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-          }
-        } else if (ch == '\n' || ch == '\r') {
-          // Строковый литерал внутри- JSON не может прерываться символами \r или \n
-          throw json::ParsingError("Unexpected end of line"s);
-        } else {
-          // Просто считываем очередной символ и помещаем его в результирующую строку
-          s.push_back(ch);
-        }
-        ++it;
+        case 't':
+          s.push_back('\t');
+          break;
+        case 'r':
+          s.push_back('\r');
+          break;
+        case '"':
+          s.push_back('"');
+          break;
+        case '\\':
+          s.push_back('\\');
+          break;
+        default:
+          throw json::ParsingError("Unrecognized escape sequence \\"s + escaped_char);
       }
-
-      return s;
     }
+  }
 
-    Node LoadString(istream &input) {
-      return Node(std::move(LoadStringPars(input)));
+  void Reader::LoadLiteral(std::string_view literal, const std::string &error) {
+    if (text_.substr(pos_, literal.size()) != literal) {
+      throw json::ParsingError(error);
     }
+    pos_ += literal.size();
+  }
 
-    Node LoadDict(istream &input) {
-      Dict result;
-      char c;
+  void Reader::SkipDigits() {
+    if (pos_ == text_.size() || !IsDigit(text_[pos_])) {
+      throw json::ParsingError("A digit is expected"s);
+    }
+    while (pos_ < text_.size() && IsDigit(text_[pos_])) {
+      ++pos_;
+    }
+  }
 
-      for (; input >> c && c != '}';) {
-        if (c == ',') {
-          input >> c;
-        }
+  // Грамматика числа проверяется при разборе, преобразование делает from_chars прямо по буферу
+  Node Reader::LoadNumber() {
+    const size_t begin = pos_;
+    auto peek = [this] {
+      return pos_ < text_.size() ? text_[pos_] : '\0';
+    };
+    if (peek() == '-') {
+      ++pos_;
+    }
+    if (peek() == '0') {
+      ++pos_;
+    } else {
+      SkipDigits();
+    }
 
-        string key = LoadString(input).AsString();
-        input >> c;
-        result.insert({move(key), LoadNode(input)});
-      }
-      if (c != '}' && c != ':') {
-        throw json::ParsingError("Bad data for dictionary");
+    bool is_int = true;
+    if (peek() == '.') {
+      ++pos_;
+      SkipDigits();
+      is_int = false;
+    }
+    if (const char ch = peek(); ch == 'e' || ch == 'E') {
+      ++pos_;
+      if (const char sign = peek(); sign == '+' || sign == '-') {
+        ++pos_;
       }
-
-      return Node(move(result));
+      SkipDigits();
+      is_int = false;
     }
 
-    Node LoadInt(istream &input) {
-
-      auto num = LoadNumber(input);
-      if (std::get_if<int>(&num)) {
-        return Node(std::get<int>(num));
-      }
-      return Node(std::get<double>(num));
-    }
-
-    Node LoadNode(istream &input) {
-      char c;
-      input >> c;
-
-      if (c == '[') {
-        return LoadArray(input);
-      } else if (c == '{') {
-        return LoadDict(input);
-      } else if (c == '"') {
-        return LoadString(input);
-      } else if (c == 'n') {
-        char null_[4];
-        input.putback(c);
-        input.read(null_, 4);
-        string line = {null_};
-        if (line.find("null") == std::string::npos) {
-          throw json::ParsingError("Bad data for null");
-        }
-        return Node();
-      } else if (c == 't') {
-        char true_[4];
-        input.putback(c);
-        input.read(true_, 4);
-        string line = {true_};
-
-        if (line.find("true") == std::string::npos) {
-          throw json::ParsingError("Bad data bool");
-        }
-        return Node(true);
-      } else if (c == 'f') {
-        char false_[5];
-        input.putback(c);
-        input.read(false_, 5);
-        string line = {false_};
-        if (line.find("false") == std::string::npos) {
-          throw json::ParsingError("Bad data bool");
-        }
-        return Node(false);
-      } else if (c == ']') {
-        throw json::ParsingError("Bad data for array");
-      } else if (c == '}') {
-        throw json::ParsingError("Bad data for dictionary");
-      } else {
-        input.putback(c);
-        return LoadInt(input);
+    const char *first = text_.data() + begin;
+    const char *last = text_.data() + pos_;
+    if (is_int) {
+      int value = 0;
+      // Целое, не помещающееся в int, становится double
+      if (const auto [ptr, ec] = std::from_chars(first, last, value); ec == std::errc{} && ptr == last) {
+        return Node(value);
       }
     }
+    double value = 0;
+    if (const auto [ptr, ec] = std::from_chars(first, last, value); ec != std::errc{} || ptr != last) {
+      throw json::ParsingError("Failed to convert "s + std::string(first, last) + " to number"s);
+    }
+    return Node(value);
+  }
 
-  } // namespace
 
   bool Node::AsBool() const {
     if (!IsBool()) {
@@ -324,8 +383,34 @@ namespace json {
     return root_;
   }
 
+  std::string ReadText(istream &input) {
+    std::string text;
+    // Размер файла известен заранее, и он читается одним вызовом. Для каналов позиция
+    // недоступна, тогда поток читается большими блоками.
+    const auto begin = input.tellg();
+    if (begin != istream::pos_type(-1) && input.seekg(0, ios::end)) {
+      const auto end = input.tellg();
+      input.seekg(begin);
+      if (end != istream::pos_type(-1) && end > begin) {
+        text.resize(static_cast<size_t>(end - begin));
+        input.read(text.data(), static_cast<streamsize>(text.size()));
+        text.resize(static_cast<size_t>(input.gcount()));
+      }
+    }
+    input.clear();
+    char buffer[1 << 16];
+    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+      text.append(buffer, static_cast<size_t>(input.gcount()));
+    }
+    return text;
+  }
+
   Document Load(istream &input) {
-    return Document{LoadNode(input)};
+    return Load(ReadText(input));
+  }
+
+  Document Load(std::string_view text) {
+    return Document{Reader(text).ReadNode()};
   }
 
   void PrintNode(const Node &node, std::ostream &out);
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 
@@ -25,7 +26,7 @@ namespace json {
     using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>;
 
     template<typename Type>
-    Node(Type value) : value_(value) {}
+    Node(Type value) : value_(std::move(value)) {}
 
     bool IsInt() const;
 
@@ -90,8 +91,94 @@ namespace json {
     Node root_;
   };
 
+  // Потоковый разбор текста в памяти без построения дерева. Обработчик вызывается на каждый
+  // ключ словаря или элемент массива и сам читает значение: типизированным методом,
+  // вложенным обходом или целиком через ReadNode. Так большие массивы можно разбирать
+  // сразу в свои структуры.
+  class Reader {
+  public:
+    explicit Reader(std::string_view text) : text_(text) {
+    }
+
+    // func(std::string_view key) должен прочитать значение ключа
+    template<typename Func>
+    void ForEachEntry(Func func);
+
+    // func() должен прочитать очередной элемент
+    template<typename Func>
+    void ForEachElement(Func func);
+
+    Node ReadNode();
+
+    std::string ReadString();
+
+    int ReadInt();
+
+    double ReadDouble();
+
+    bool ReadBool();
+
+  private:
+    static bool IsSpace(char c);
+
+    static bool IsDigit(char c);
+
+    void SkipSpaces();
+
+    // Следующий значащий символ или '\0' в конце текста
+    char PeekSignificant();
+
+    // Пропускает открывающую скобку составного значения
+    void Expect(char c, const char *error);
+
+    // Ключ следующей пары словаря, false - словарь закончился
+    bool NextKey(std::string &key);
+
+    // false - массив закончился
+    bool NextElement();
+
+    Node LoadArray();
+
+    Node LoadDict();
+
+    // Позиция сразу после открывающей кавычки
+    std::string LoadString();
+
+    void LoadLiteral(std::string_view literal, const std::string &error);
+
+    void SkipDigits();
+
+    Node LoadNumber();
+
+    std::string_view text_;
+    size_t pos_ = 0;
+  };
+
+  template<typename Func>
+  void Reader::ForEachEntry(Func func) {
+    Expect('{', "Bad data for dictionary");
+    std::string key;
+    while (NextKey(key)) {
+      func(std::string_view(key));
+    }
+  }
+
+  template<typename Func>
+  void Reader::ForEachElement(Func func) {
+    Expect('[', "Bad data for array");
+    while (NextElement()) {
+      func();
+    }
+  }
+
+  // Читает поток до конца в одну строку
+  std::string ReadText(std::istream &input);
+
+  // Читает поток до конца и разбирает первое значение в нём
   Document Load(std::istream &input);
 
+  Document Load(std::string_view text);
+
   void Print(const Document &doc, std::ostream &output);
 
 } // namespace json
\ No newline at end of file
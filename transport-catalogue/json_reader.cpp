@@ -1,130 +1,242 @@
 #include "json_reader.h"
 #include "router.h"
+#include "serialization.h"
+#include <optional>
 #include <sstream>
+#include <stdexcept>
 
 namespace transport_catalogue {
 
-  InputBusData ParseBusInfo(const json::Dict& dict_bus_info) {
-    std::vector<std::string> stops;
-    bool is_roundtrip = true;
-    for (auto &memb: dict_bus_info.at("stops").AsArray()) {
-      stops.push_back(memb.AsString());
-    }
-    if (!dict_bus_info.at("is_roundtrip").AsBool()) {
-      is_roundtrip = false;
-      std::vector<std::string> temp_vect = stops;
-      temp_vect.pop_back(); // обрезаем последний элемент, чтобы автобус поехал на предпосл остановку
-      std::reverse(temp_vect.begin(), temp_vect.end());
-      for (auto &memb: temp_vect) {
-        stops.push_back(move(memb));
+  InputBusData MakeBusData(std::string name, std::vector<std::string> stops, bool is_roundtrip) {
+    if (!is_roundtrip && !stops.empty()) {
+      // обратный путь начинается с предпоследней остановки
+      const size_t forward_size = stops.size();
+      stops.reserve(forward_size * 2 - 1);
+      for (size_t index = forward_size - 1; index-- > 0;) {
+        stops.push_back(stops[index]);
       }
     }
-
-    return {dict_bus_info.at("name").AsString(), stops, is_roundtrip};
+    return {std::move(name), std::move(stops), is_roundtrip};
   }
 
-  Stop ParseStopInfo(const json::Dict& dict_stop_info) {
-    std::unordered_map<std::string, int64_t> stops_to_dists;
-
-    if (dict_stop_info.count("road_distances")) {
-      for (auto [stop, dist]: dict_stop_info.at("road_distances").AsMap()) {
-
-        stops_to_dists.insert({stop, dist.AsInt()});
+  RoutingSettings ParseRoutingSettings(const json::Node &route_prop) {
+    const auto &settings = route_prop.AsMap();
+    RoutingSettings result;
+    result.bus_velocity = settings.at("bus_velocity").AsInt() * 16.6666667;
+    result.bus_wait_time = settings.at("bus_wait_time").AsDouble();
+    if (settings.count("algorithm")) {
+      const auto &algorithm = settings.at("algorithm").AsString();
+      if (algorithm == "dijkstra") {
+        result.algorithm = RoutingAlgorithm::DIJKSTRA;
+      } else if (algorithm == "all_pairs") {
+        result.algorithm = RoutingAlgorithm::ALL_PAIRS;
+      } else if (algorithm == "contraction_hierarchies") {
+        result.algorithm = RoutingAlgorithm::CONTRACTION_HIERARCHIES;
+      } else if (algorithm == "a_star") {
+        result.algorithm = RoutingAlgorithm::A_STAR;
+      } else if (algorithm == "raptor") {
+        result.algorithm = RoutingAlgorithm::RAPTOR;
+      } else {
+        throw std::invalid_argument("Unknown routing algorithm: " + algorithm);
       }
     }
-    geo::Coordinates coords = {dict_stop_info.at("latitude").AsDouble(), dict_stop_info.at("longitude").AsDouble()};
-
-    return {dict_stop_info.at("name").AsString(), coords, stops_to_dists};
+    if (settings.count("all_pairs_precision")) {
+      const auto &precision = settings.at("all_pairs_precision").AsString();
+      if (precision == "double") {
+        result.all_pairs_precision = AllPairsPrecision::DOUBLE;
+      } else if (precision == "float") {
+        result.all_pairs_precision = AllPairsPrecision::FLOAT;
+      } else {
+        throw std::invalid_argument("Unknown all pairs precision: " + precision);
+      }
+    }
+    return result;
   }
 
   void ProcessRequest(std::istream &input, std::ostream &output, TransportCatalogue &catalogue) {
 
-    auto doc = json::Load(input);
-    json::Dict result_dict = doc.GetRoot().AsMap();
+    const json::Dict result_dict = LoadRequestsDocument(input, catalogue);
 
-    json::Array base_req = result_dict.at("base_requests").AsArray();
-    json::Array stat_req = result_dict.at("stat_requests").AsArray();
-    json::Node rander_sett = result_dict.at("render_settings");
-    json::Node routing_properties = result_dict.at("routing_settings");
+    const json::Array &stat_req = result_dict.at("stat_requests").AsArray();
+    const json::Node &rander_sett = result_dict.at("render_settings");
+    const json::Node &routing_properties = result_dict.at("routing_settings");
     SvgInfo svg_properties = ParsePropLine(rander_sett);
-    ParseAndExecuteRequests(base_req, catalogue);
-    ExecuteRequests(stat_req, output, catalogue, svg_properties, routing_properties);
+    // Создание роутера 1 раз, чтобы потом к нему обращаться
+    RoutingService routing_service(catalogue, ParseRoutingSettings(routing_properties), ROUTE_CACHE_CAPACITY);
+    ExecuteRequests(stat_req, output, catalogue, svg_properties, routing_service);
   }
 
-  void ParseAndExecuteRequests(const json::Array& base_req, TransportCatalogue &catalogue) {
-    Requests requests;
-    // Обработка заполнения базы
-    for (auto &node: base_req) {
-      if (node.AsMap().at("type").AsString() == "Stop") {
-        requests.stops_requests.push_back(node);
-        catalogue.AddStop(ParseStopInfo(node.AsMap()));
-      } else {
-        requests.bus_requests.push_back(node);
+  void MakeBase(std::istream &input, TransportCatalogue &catalogue) {
+    const json::Dict result_dict = LoadRequestsDocument(input, catalogue);
+
+    SvgInfo svg_properties = ParsePropLine(result_dict.at("render_settings"));
+    RoutingService routing_service(catalogue, ParseRoutingSettings(result_dict.at("routing_settings")), 0);
+    const auto &file = result_dict.at("serialization_settings").AsMap().at("file").AsString();
+    serialization::SaveBase(file, catalogue, svg_properties, routing_service.GetRouter());
+  }
+
+  void ProcessStatRequests(std::istream &input, std::ostream &output, TransportCatalogue &catalogue) {
+    auto doc = json::Load(input);
+    const json::Dict &result_dict = doc.GetRoot().AsMap();
+
+    const auto &file = result_dict.at("serialization_settings").AsMap().at("file").AsString();
+    auto base = serialization::LoadBase(file, catalogue);
+    RoutingService routing_service(catalogue, base.routing_settings, std::move(base.router_data),
+                                   ROUTE_CACHE_CAPACITY);
+    ExecuteRequests(result_dict.at("stat_requests").AsArray(), output, catalogue, base.render_settings,
+                    routing_service);
+  }
+
+  BaseRequestsLoader::BaseRequestsLoader(TransportCatalogue &catalogue) : catalogue_(catalogue) {
+  }
+
+  void BaseRequestsLoader::AddStop(InputStopData stop) {
+    Stop *from = catalogue_.AddStop({std::move(stop.name), stop.coordinates});
+    for (auto &[to, distance]: stop.stops_to_dists) {
+      distances_.push_back({from, std::move(to), distance});
+    }
+  }
+
+  void BaseRequestsLoader::AddBus(InputBusData bus) {
+    buses_.push_back(std::move(bus));
+  }
+
+  void BaseRequestsLoader::Finish() {
+    for (const auto &[from, to, distance]: distances_) {
+      catalogue_.SetDistance(distance, from, FindStop(to));
+    }
+    distances_.clear();
+    for (auto &bus: buses_) {
+      std::vector<Stop *> stops;
+      stops.reserve(bus.stops.size());
+      for (const auto &stop: bus.stops) {
+        stops.push_back(FindStop(stop));
       }
+      catalogue_.AddBus({std::move(bus.name), std::move(stops), bus.is_roundtrip});
     }
+    buses_.clear();
+  }
 
-    for (auto &stop_node: requests.stops_requests) {
-      auto stop_info = ParseStopInfo(std::move(stop_node).AsMap());
+  Stop *BaseRequestsLoader::FindStop(const std::string &name) {
+    Stop *stop = catalogue_.FindStop(name);
+    if (!stop) {
+      throw std::invalid_argument("Unknown stop: " + name);
+    }
+    return stop;
+  }
 
-      if (stop_info.stops_to_dists.size() != 0) {
-        for (auto &pair: stop_info.stops_to_dists) {
-          catalogue.SetDistance(pair.second, catalogue.FindStop(stop_info.name), catalogue.FindStop(pair.first));
-        }
+  namespace {
+    // Ошибка того же типа, что бросал бы map::at при разборе через дерево
+    void CheckKeyPresent(bool is_present, std::string_view key) {
+      if (!is_present) {
+        throw std::out_of_range("Base request has no \"" + std::string(key) + "\" key");
       }
     }
+  }
 
-    for (auto &bus_node: requests.bus_requests) {
-      std::vector<Stop *> stops;
-      auto bus_info = ParseBusInfo(std::move(bus_node).AsMap());
-      for (auto &stop: bus_info.stops) {
-        stops.push_back(catalogue.FindStop(stop));
+  void LoadBaseRequests(json::Reader &reader, BaseRequestsLoader &loader) {
+    reader.ForEachElement([&reader, &loader] {
+      // Ключи объекта могут идти в любом порядке, поэтому поля собираются до конца объекта
+      std::optional<std::string> type;
+      std::optional<std::string> name;
+      std::optional<double> latitude;
+      std::optional<double> longitude;
+      std::optional<std::vector<std::pair<std::string, int64_t>>> stops_to_dists;
+      std::optional<std::vector<std::string>> stops;
+      std::optional<bool> is_roundtrip;
+      // Как и при разборе в дерево, из повторяющихся ключей действует первый
+      reader.ForEachEntry([&](std::string_view key) {
+        if (key == "type" && !type) {
+          type = reader.ReadString();
+        } else if (key == "name" && !name) {
+          name = reader.ReadString();
+        } else if (key == "latitude" && !latitude) {
+          latitude = reader.ReadDouble();
+        } else if (key == "longitude" && !longitude) {
+          longitude = reader.ReadDouble();
+        } else if (key == "road_distances" && !stops_to_dists) {
+          stops_to_dists.emplace();
+          reader.ForEachEntry([&reader, &stops_to_dists](std::string_view stop) {
+            stops_to_dists->emplace_back(std::string(stop), reader.ReadInt());
+          });
+        } else if (key == "stops" && !stops) {
+          stops.emplace();
+          reader.ForEachElement([&reader, &stops] {
+            stops->push_back(reader.ReadString());
+          });
+        } else if (key == "is_roundtrip" && !is_roundtrip) {
+          is_roundtrip = reader.ReadBool();
+        } else {
+          reader.ReadNode();
+        }
+      });
+      CheckKeyPresent(type.has_value(), "type");
+      if (*type == "Stop") {
+        CheckKeyPresent(name.has_value(), "name");
+        CheckKeyPresent(latitude.has_value(), "latitude");
+        CheckKeyPresent(longitude.has_value(), "longitude");
+        InputStopData stop{std::move(*name), {*latitude, *longitude}, {}};
+        if (stops_to_dists) {
+          stop.stops_to_dists = std::move(*stops_to_dists);
+        }
+        loader.AddStop(std::move(stop));
+      } else if (*type == "Bus") {
+        CheckKeyPresent(name.has_value(), "name");
+        CheckKeyPresent(stops.has_value(), "stops");
+        CheckKeyPresent(is_roundtrip.has_value(), "is_roundtrip");
+        loader.AddBus(MakeBusData(std::move(*name), std::move(*stops), *is_roundtrip));
+      } else {
+        throw std::invalid_argument("Unknown base request type: " + *type);
       }
-      catalogue.AddBus({bus_info.name, stops, bus_info.is_roundtrip});
-      for (auto stop: stops) {
-        catalogue.GetStopsToBusesMap()[stop].insert(std::string_view{catalogue.GetBusesDeque().back().name});
+    });
+  }
+
+  json::Dict LoadRequestsDocument(std::istream &input, TransportCatalogue &catalogue) {
+    const std::string text = json::ReadText(input);
+    json::Reader reader(text);
+    BaseRequestsLoader loader(catalogue);
+    json::Dict result;
+    reader.ForEachEntry([&](std::string_view key) {
+      if (key == "base_requests") {
+        LoadBaseRequests(reader, loader);
+      } else {
+        result.emplace(std::string(key), reader.ReadNode());
       }
-    }
+    });
+    loader.Finish();
+    return result;
   }
 
   void
   ExecuteRequests(const json::Array &stat_req, std::ostream &output, TransportCatalogue &catalogue, SvgInfo &properties,
-                  const json::Node& route_prop) {
-    // Создание роутера 1 раз, чтобы потом к нему обращаться
-    auto settings = route_prop.AsMap();
-    const auto speed = settings.at("bus_velocity").AsInt() * 16.6666667;
-    const auto wait_time = settings.at("bus_wait_time").AsDouble();
-    TransportRouter transport_router(catalogue, speed, wait_time);
-    auto result_graph = transport_router.GetGraph();
-    graph::Router<double> result_router(result_graph);
-
-    bool isfirstreq = true;
+                  RoutingService &routing_service) {
     json::Array array;
+    const TransportRouter &transport_router = routing_service.GetRouter();
+    RouteCache &route_cache = routing_service.GetRouteCache();
     for (auto &request_node: stat_req) {
       std::string type = request_node.AsMap().at("type").AsString();
       if (type == "Bus" || type == "Stop") {
-        array.emplace_back(ProcessBusOrStop(type, isfirstreq, request_node, catalogue));
+        array.emplace_back(ProcessBusOrStop(type, request_node, catalogue));
       } else if (type == "Route") {
-        json::Dict result;
-        if (isfirstreq) {
-          result = SerializeRouteDataToJSON(request_node, catalogue, route_prop, result_router);
-          isfirstreq = false;
+        const auto &request = request_node.AsMap();
+        if (request.count("pareto") && request.at("pareto").AsBool()) {
+          array.emplace_back(SerializeParetoRoutesToJSON(request_node, catalogue, transport_router));
         } else {
-          result = SerializeRouteDataToJSON(request_node, catalogue, route_prop, result_router);
+          array.emplace_back(SerializeRouteDataToJSON(request_node, catalogue, transport_router, &route_cache));
         }
-        array.emplace_back(result);
+      } else if (type == "RouteMatrix") {
+        array.emplace_back(SerializeRouteMatrixToJSON(request_node, catalogue, transport_router));
+      } else if (type == "Isochrone") {
+        array.emplace_back(SerializeIsochroneToJSON(request_node, catalogue, properties, transport_router));
+      } else if (type == "NearestStops" || type == "StopsInRadius") {
+        array.emplace_back(SerializeNearbyStopsToJSON(request_node, catalogue));
       } else {
         MapRenderer renderer(catalogue, properties);
         svg::Document &result_doc = renderer.Render();
         std::ostringstream out;
         result_doc.Render(out);
         std::string map_rend_string = out.str();
-        json::Dict result = SerializeMapDataToJSON(request_node, map_rend_string);
-        if (isfirstreq) {
-          array.emplace_back(result);
-          isfirstreq = false;
-        } else {
-          array.emplace_back(result);
-        }
+        array.emplace_back(SerializeMapDataToJSON(request_node, map_rend_string));
       }
     }
     json::Print(json::Document{array}, output);
@@ -145,13 +257,13 @@ namespace transport_catalogue {
     auto request_id = request_node.AsMap().at("id");
 
     if (catalogue.FindBus(name_of_the_bus)) {
-      auto data_of_bus = catalogue.GetBusInfo(name_of_the_bus);
+      const auto &data_of_bus = catalogue.GetBusInfo(name_of_the_bus);
 
       auto result = json::Builder{}.StartDict().Key("stop_count").Value(
           static_cast<int>(data_of_bus.numb_of_stops)).Key("request_id").Value(request_id).Key(
           "unique_stop_count").Value(static_cast<int>(data_of_bus.numb_of_unique_stops)).Key("route_length").Value(
           static_cast<int>(data_of_bus.true_length)).Key("curvature").Value(
-          static_cast<double>(data_of_bus.true_length / data_of_bus.length)).EndDict().Build();
+          data_of_bus.curvature).EndDict().Build();
 
       return result.AsMap();
     } else {
@@ -169,8 +281,8 @@ namespace transport_catalogue {
 
     if (catalogue.FindStop(name_of_the_stop)) {
       json::Array pas_bus;
-      for (auto bus: catalogue.GetStopInfo(name_of_the_stop).passing_buses) {
-        pas_bus.emplace_back(std::string{bus});
+      for (const uint32_t bus_id: catalogue.GetStopInfo(name_of_the_stop).passing_buses) {
+        pas_bus.emplace_back(catalogue.GetBusFromId(bus_id).name);
       }
       auto result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("buses").Value(
           pas_bus).EndDict().Build();
@@ -183,53 +295,216 @@ namespace transport_catalogue {
     }
   }
 
-  json::Dict SerializeRouteDataToJSON(const json::Node& request_node, TransportCatalogue &catalogue, const json::Node &route_prop, graph::Router<double> &result_router) {
-    json::Node result;
+  json::Dict SerializeRouteDataToJSON(const json::Node& request_node, TransportCatalogue &catalogue,
+                                      const TransportRouter &transport_router, RouteCache *route_cache) {
 
     int request_id = request_node.AsMap().at("id").AsInt();
     std::string_view first_stop = request_node.AsMap().at("from").AsString();
     std::string_view last_stop = request_node.AsMap().at("to").AsString();
-    auto settings = route_prop.AsMap();
-    auto result_route = result_router.BuildRoute(catalogue.GetStopId(first_stop), catalogue.GetStopId(last_stop));
+    // По запросу в ответ добавляется число просмотренных при поиске вершин, если алгоритм его считает
+    const bool with_stats = request_node.AsMap().count("with_stats") && request_node.AsMap().at("with_stats").AsBool()
+                            && transport_router.IsSearchStatsSupported();
+    const RouteCache::Key key{catalogue.GetStopId(first_stop), catalogue.GetStopId(last_stop)};
+    // Статистика нужна от настоящего поиска, поэтому такие запросы идут мимо кэша
+    const bool use_cache = route_cache && !with_stats;
+    std::optional<RouteCache::Value> serialized_route;
+    if (use_cache) {
+      route_cache->Validate(catalogue.GetVersion(), transport_router.GetVersion());
+      serialized_route = route_cache->Get(key);
+    }
+
+    graph::SearchStats stats;
+    if (!serialized_route) {
+      serialized_route.emplace();
+      auto result_route = transport_router.BuildRoute(key.first, key.second, with_stats ? &stats : nullptr);
+
+      if (result_route) {
+        *serialized_route = std::make_shared<const SerializedRoute>(SerializedRoute{
+            result_route.value().total_time,
+            SerializeRouteItems(result_route.value(), catalogue, transport_router.GetSettings().bus_wait_time)});
+      }
+      if (use_cache) {
+        route_cache->Put(key, *serialized_route);
+      }
+    }
 
-    if (result_route) {
+    // Ответ собирается напрямую: элементы маршрута копируются из кэша в ответ один раз
+    json::Dict result{{"request_id", request_id}};
+    if (*serialized_route) {
+      result.emplace("total_time", (*serialized_route)->total_time);
+      result.emplace("items", (*serialized_route)->items);
+    } else {
+      result.emplace("error_message", "not found");
+    }
 
-      double wait_time = settings.at("bus_wait_time").AsDouble();
-      json::Array items;
+    if (with_stats) {
+      result.emplace("settled_vertices", static_cast<int>(stats.settled_vertices));
+    }
+    return result;
+  }
 
-      for (auto &item: result_route.value().edges) {
-        auto curr_edge = result_router.GetGraph().GetEdge(item);
+  json::Array SerializeRouteItems(const TransportRouter::Route &route, TransportCatalogue &catalogue,
+                                  double wait_time) {
+    json::Array items;
+    items.reserve(route.legs.size() * 2);
 
-        auto wait_item = json::Builder{}.StartDict().Key("type").Value("Wait").Key("stop_name").Value(
-            catalogue.GetStopFromId(curr_edge.from)).Key("time").Value(wait_time).EndDict().Build();
+    for (auto &curr_edge: route.legs) {
 
-        double bus_travel_time = curr_edge.weight - route_prop.AsMap().at("bus_wait_time").AsDouble();
-        auto bus_item = json::Builder{}.StartDict().Key("type").Value("Bus").Key("bus").Value(curr_edge.bus_name).Key(
-            "span_count").Value(curr_edge.span_count).Key("time").Value(bus_travel_time).EndDict().Build();
+      auto wait_item = json::Builder{}.StartDict().Key("type").Value("Wait").Key("stop_name").Value(
+          catalogue.GetStopFromId(curr_edge.from)).Key("time").Value(wait_time).EndDict().Build();
 
-        items.push_back(std::move(wait_item));
-        items.push_back(std::move(bus_item));
+      double bus_travel_time = curr_edge.weight - wait_time;
+      auto bus_item = json::Builder{}.StartDict().Key("type").Value("Bus").Key("bus").Value(
+          catalogue.GetBusFromId(curr_edge.bus_id).name).Key(
+          "span_count").Value(curr_edge.span_count).Key("time").Value(bus_travel_time).EndDict().Build();
+
+      items.push_back(std::move(wait_item));
+      items.push_back(std::move(bus_item));
+    }
+    return items;
+  }
+
+  json::Dict SerializeParetoRoutesToJSON(const json::Node& request_node, TransportCatalogue &catalogue,
+                                         const TransportRouter &transport_router) {
+    auto request_id = request_node.AsMap().at("id");
+    const auto &request = request_node.AsMap();
+    std::optional<size_t> max_transfers;
+    if (request.count("max_transfers")) {
+      const int value = request.at("max_transfers").AsInt();
+      if (value < 0) {
+        throw std::invalid_argument("max_transfers must be non-negative");
       }
+      max_transfers = static_cast<size_t>(value);
+    }
 
-      result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("total_time").Value(
-          result_route.value().weight).Key("items").Value(std::move(items)).EndDict().Build();
-    } else {
-      result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value(
+    const std::string &from = request.at("from").AsString();
+    const std::string &to = request.at("to").AsString();
+    std::vector<TransportRouter::Route> routes;
+    if (catalogue.FindStop(from) && catalogue.FindStop(to)) {
+      routes = transport_router.BuildParetoRoutes(catalogue.GetStopId(from), catalogue.GetStopId(to), max_transfers);
+    }
+    if (routes.empty()) {
+      auto result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value(
           "not found").EndDict().Build();
+      return result.AsMap();
     }
 
+    // Варианты по возрастанию числа пересадок, каждый следующий быстрее
+    json::Array options;
+    options.reserve(routes.size());
+    for (const auto &route: routes) {
+      const int transfer_count = route.legs.empty() ? 0 : static_cast<int>(route.legs.size() - 1);
+      options.emplace_back(json::Builder{}.StartDict().Key("total_time").Value(route.total_time).Key(
+          "transfer_count").Value(transfer_count).Key("items").Value(
+          SerializeRouteItems(route, catalogue, transport_router.GetSettings().bus_wait_time)).EndDict().Build());
+    }
+    auto result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("routes").Value(
+        std::move(options)).EndDict().Build();
     return result.AsMap();
   }
 
-  json::Dict ProcessBusOrStop(std::string_view type, bool& is_first_request, const json::Node& request_node, TransportCatalogue& catalogue) {
-    json::Dict result;
-    if (is_first_request) {
-      result = type == "Bus" ? SerializeBusDataToJSON(request_node, catalogue) : SerializeStopDataToJSON(request_node, catalogue);
-      is_first_request = false;
-    } else {
-      result = type == "Bus" ? SerializeBusDataToJSON(request_node, catalogue) : SerializeStopDataToJSON(request_node, catalogue);
+  json::Dict SerializeRouteMatrixToJSON(const json::Node& request_node, TransportCatalogue &catalogue,
+                                        const TransportRouter &transport_router) {
+    auto request_id = request_node.AsMap().at("id");
+
+    // Списки остановок переводятся в номера вершин, неизвестная остановка - ошибка всего запроса
+    auto parse_stops = [&catalogue](const json::Node &stops_node) -> std::optional<std::vector<graph::VertexId>> {
+      std::vector<graph::VertexId> result;
+      for (const auto &stop_node: stops_node.AsArray()) {
+        if (!catalogue.FindStop(stop_node.AsString())) {
+          return std::nullopt;
+        }
+        result.push_back(catalogue.GetStopId(stop_node.AsString()));
+      }
+      return result;
+    };
+    const auto from = parse_stops(request_node.AsMap().at("from"));
+    const auto to = parse_stops(request_node.AsMap().at("to"));
+    if (!from || !to) {
+      auto result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value(
+          "not found").EndDict().Build();
+      return result.AsMap();
+    }
+
+    // Ответ - массив строк с временем в пути, null для недостижимых пар
+    json::Array matrix;
+    matrix.reserve(from->size());
+    for (const auto &row: transport_router.BuildRouteMatrix(*from, *to)) {
+      json::Array times;
+      times.reserve(row.size());
+      for (const auto &time: row) {
+        times.emplace_back(time ? json::Node{*time} : json::Node{nullptr});
+      }
+      matrix.emplace_back(std::move(times));
+    }
+    auto result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("matrix").Value(
+        std::move(matrix)).EndDict().Build();
+    return result.AsMap();
+  }
+
+  json::Dict SerializeIsochroneToJSON(const json::Node& request_node, TransportCatalogue &catalogue,
+                                      const SvgInfo &properties, const TransportRouter &transport_router) {
+    const auto &request = request_node.AsMap();
+    auto request_id = request.at("id");
+    const std::string &from = request.at("from").AsString();
+    if (!catalogue.FindStop(from)) {
+      auto result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value(
+          "not found").EndDict().Build();
+      return result.AsMap();
+    }
+
+    const auto reachable = transport_router.BuildIsochrone(catalogue.GetStopId(from),
+                                                           request.at("max_time").AsDouble());
+    json::Array stops;
+    stops.reserve(reachable.size());
+    for (const auto &[stop_id, time]: reachable) {
+      stops.emplace_back(json::Builder{}.StartDict().Key("stop_name").Value(catalogue.GetStopFromId(stop_id)).Key(
+          "time").Value(time).EndDict().Build());
+    }
+    json::Dict result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("stops").Value(
+        std::move(stops)).EndDict().Build().AsMap();
+
+    // По запросу добавляется карта только достижимой части сети
+    if (request.count("render") && request.at("render").AsBool()) {
+      std::vector<bool> is_stop_visible(catalogue.GetStopsCount(), false);
+      for (const auto &[stop_id, time]: reachable) {
+        is_stop_visible[stop_id] = true;
+      }
+      MapRenderer renderer(catalogue, properties);
+      svg::Document document;
+      renderer.RenderSubnetwork(is_stop_visible, document);
+      std::ostringstream out;
+      document.Render(out);
+      result["map"] = out.str();
     }
     return result;
   }
 
+  json::Dict SerializeNearbyStopsToJSON(const json::Node& request_node, const TransportCatalogue &catalogue) {
+    const auto &request = request_node.AsMap();
+    auto request_id = request.at("id");
+    const geo::Coordinates point{request.at("latitude").AsDouble(), request.at("longitude").AsDouble()};
+
+    std::vector<std::pair<size_t, double>> nearby;
+    if (request.at("type").AsString() == "NearestStops") {
+      const int count = request.at("count").AsInt();
+      nearby = catalogue.FindNearestStops(point, count > 0 ? static_cast<size_t>(count) : 0);
+    } else {
+      nearby = catalogue.FindStopsInRadius(point, request.at("radius").AsDouble());
+    }
+    json::Array stops;
+    stops.reserve(nearby.size());
+    for (const auto &[stop_id, distance]: nearby) {
+      stops.emplace_back(json::Builder{}.StartDict().Key("stop_name").Value(catalogue.GetStopFromId(stop_id)).Key(
+          "distance").Value(distance).EndDict().Build());
+    }
+    auto result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("stops").Value(
+        std::move(stops)).EndDict().Build();
+    return result.AsMap();
+  }
+
+  json::Dict ProcessBusOrStop(std::string_view type, const json::Node& request_node, TransportCatalogue& catalogue) {
+    return type == "Bus" ? SerializeBusDataToJSON(request_node, catalogue) : SerializeStopDataToJSON(request_node, catalogue);
+  }
+
 }
\ No newline at end of file
@@ -8,32 +8,95 @@
 #include "transport_router.h"
 #include "graph.h"
 #include "router.h"
+#include "route_cache.h"
+#include "routing_service.h"
 
 namespace transport_catalogue {
-  InputBusData ParseBusInfo(const json::Dict& dict_bus_info);
+  // Для некольцевого маршрута добавляет обратный путь до начальной остановки
+  InputBusData MakeBusData(std::string name, std::vector<std::string> stops, bool is_roundtrip);
 
-  Stop ParseStopInfo(const json::Dict& dict_stop_info);
+  RoutingSettings ParseRoutingSettings(const json::Node &route_prop);
 
-  struct Requests {
-    json::Array stops_requests;
-    json::Array bus_requests;
+  // Число ответов Route, которые хранятся для повторных запросов
+  inline constexpr size_t ROUTE_CACHE_CAPACITY = 4096;
+
+  // Заполняет справочник по запросам base_requests. Остановки добавляются сразу, а расстояния
+  // и маршруты могут ссылаться на остановки, описанные позже, поэтому откладываются до Finish.
+  class BaseRequestsLoader {
+  public:
+    explicit BaseRequestsLoader(TransportCatalogue &catalogue);
+
+    void AddStop(InputStopData stop);
+
+    void AddBus(InputBusData bus);
+
+    // Задаёт отложенные расстояния, затем добавляет маршруты в порядке описания
+    void Finish();
+
+  private:
+    struct PendingDistance {
+      Stop *from;
+      std::string to;
+      int64_t distance;
+    };
+
+    Stop *FindStop(const std::string &name);
+
+    TransportCatalogue &catalogue_;
+    std::vector<PendingDistance> distances_;
+    std::vector<InputBusData> buses_;
   };
 
-  void ParseAndExecuteRequests(const json::Array& base_req, TransportCatalogue &catalogue);
+  // Разбирает массив base_requests прямо из текста, не строя для него дерево.
+  // Без обязательного поля запроса бросает std::out_of_range, при неизвестном типе - std::invalid_argument.
+  void LoadBaseRequests(json::Reader &reader, BaseRequestsLoader &loader);
+
+  // Читает документ запросов: base_requests разбираются потоково и сразу попадают в справочник,
+  // остальные разделы возвращаются деревом
+  json::Dict LoadRequestsDocument(std::istream &input, TransportCatalogue &catalogue);
 
   void
   ExecuteRequests(const json::Array &stat_req, std::ostream &output, TransportCatalogue &catalogue, SvgInfo &properties,
-                  const json::Node& route_prop);
+                  RoutingService &routing_service);
 
   void ProcessRequest(std::istream &input, std::ostream &output, TransportCatalogue &catalogue);
 
+  // Строит справочник и роутер по base_requests и сохраняет их в файл из serialization_settings
+  void MakeBase(std::istream &input, TransportCatalogue &catalogue);
+
+  // Загружает базу из файла serialization_settings и отвечает на stat_requests
+  void ProcessStatRequests(std::istream &input, std::ostream &output, TransportCatalogue &catalogue);
+
   json::Dict SerializeBusDataToJSON(const json::Node& request_node, TransportCatalogue &catalogue);
 
   json::Dict SerializeStopDataToJSON(const json::Node& request_node, TransportCatalogue &catalogue);
 
   json::Dict SerializeMapDataToJSON(const json::Node& request_node, const std::string &map_rend_string);
 
-  json::Dict SerializeRouteDataToJSON(const json::Node& request_node, TransportCatalogue &catalogue, const json::Node &route_prop,
-                               graph::Router<double> &result_router);
-  json::Dict ProcessBusOrStop(std::string_view type, bool& is_first_request, const json::Node& request_node, TransportCatalogue& catalogue);
+  // route_cache - необязательный кэш готовых ответов для повторяющихся пар остановок
+  json::Dict SerializeRouteDataToJSON(const json::Node& request_node, TransportCatalogue &catalogue,
+                                      const TransportRouter &transport_router, RouteCache *route_cache = nullptr);
+
+  // Части Wait и Bus ответа Route по поездкам маршрута
+  json::Array SerializeRouteItems(const TransportRouter::Route &route, TransportCatalogue &catalogue,
+                                  double wait_time);
+
+  // Route с "pareto": true - все маршруты, оптимальные по времени и числу пересадок,
+  // "max_transfers" ограничивает число пересадок. Для неизвестной остановки ответ "not found".
+  json::Dict SerializeParetoRoutesToJSON(const json::Node& request_node, TransportCatalogue &catalogue,
+                                         const TransportRouter &transport_router);
+
+  json::Dict SerializeRouteMatrixToJSON(const json::Node& request_node, TransportCatalogue &catalogue,
+                                        const TransportRouter &transport_router);
+  // Isochrone: все остановки, до которых из "from" можно доехать не более чем за "max_time"
+  // минут, со временем в пути. С "render": true в ответ добавляется карта достижимой части сети.
+  json::Dict SerializeIsochroneToJSON(const json::Node& request_node, TransportCatalogue &catalogue,
+                                      const SvgInfo &properties, const TransportRouter &transport_router);
+
+  // NearestStops: "count" ближайших к точке "latitude", "longitude" остановок.
+  // StopsInRadius: все остановки не дальше "radius" метров от точки.
+  // Остановки упорядочены по расстоянию в метрах, которое тоже попадает в ответ.
+  json::Dict SerializeNearbyStopsToJSON(const json::Node& request_node, const TransportCatalogue &catalogue);
+
+  json::Dict ProcessBusOrStop(std::string_view type, const json::Node& request_node, TransportCatalogue& catalogue);
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace cache {
+
+  // Ограниченный по размеру кэш, вытесняющий давно не использованные записи
+  template<typename Key, typename Value, typename Hash = std::hash<Key>>
+  class LruCache {
+  public:
+    explicit LruCache(size_t capacity) : capacity_(capacity) {
+    }
+
+    // Возвращает значение без копирования и помечает запись как последнюю использованную.
+    // nullptr - записи нет. Указатель действителен до следующего изменения кэша.
+    Value *Get(const Key &key) {
+      auto it = index_.find(key);
+      if (it == index_.end()) {
+        return nullptr;
+      }
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return &it->second->second;
+    }
+
+    void Put(const Key &key, Value value) {
+      if (capacity_ == 0) {
+        return;
+      }
+      if (auto it = index_.find(key); it != index_.end()) {
+        it->second->second = std::move(value);
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+      }
+      if (entries_.size() == capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+      }
+      entries_.emplace_front(key, std::move(value));
+      index_[key] = entries_.begin();
+    }
+
+    // Вызывает update(key, value) для всех записей, не меняя порядок вытеснения.
+    // Записи, для которых update вернул false, удаляются.
+    template<typename Update>
+    void UpdateAll(Update update) {
+      for (auto it = entries_.begin(); it != entries_.end();) {
+        if (update(std::as_const(it->first), it->second)) {
+          ++it;
+        } else {
+          index_.erase(it->first);
+          it = entries_.erase(it);
+        }
+      }
+    }
+
+    void Clear() {
+      entries_.clear();
+      index_.clear();
+    }
+
+    size_t GetSize() const {
+      return entries_.size();
+    }
+
+    size_t GetCapacity() const {
+      return capacity_;
+    }
+
+  private:
+    using Entry = std::pair<Key, Value>;
+
+    size_t capacity_;
+    std::list<Entry> entries_;
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index_;
+  };
+
+} // namespace cache
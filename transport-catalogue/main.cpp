@@ -1,8 +1,33 @@
 #include "json_reader.h"
 #include <iostream>
+#include <string_view>
 
-int main() {
+using namespace std::literals;
+
+void PrintUsage(std::ostream &stream = std::cerr) {
+  stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+}
+
+int main(int argc, char *argv[]) {
   using namespace transport_catalogue;
   TransportCatalogue catal;
-  ProcessRequest(std::cin, std::cout, catal);
-}
\ No newline at end of file
+  // Без аргументов база строится и запросы обрабатываются за один запуск
+  if (argc == 1) {
+    ProcessRequest(std::cin, std::cout, catal);
+    return 0;
+  }
+  if (argc != 2) {
+    PrintUsage();
+    return 1;
+  }
+
+  const std::string_view mode(argv[1]);
+  if (mode == "make_base"sv) {
+    MakeBase(std::cin, catal);
+  } else if (mode == "process_requests"sv) {
+    ProcessStatRequests(std::cin, std::cout, catal);
+  } else {
+    PrintUsage();
+    return 1;
+  }
+}
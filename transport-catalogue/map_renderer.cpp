@@ -85,19 +85,83 @@ namespace transport_catalogue {
       }
     }
 
-    DrawStops(coords_of_all_stops_buses, result);
+    DrawStops(coords_of_all_stops_buses, catalogue_.GetUniqueStops(), result);
 
-    DrawStopNames(coords_of_all_stops_buses, result);
+    DrawStopNames(coords_of_all_stops_buses, catalogue_.GetUniqueStops(), result);
     return result;
   }
 
-  void MapRenderer::DrawStops(const std::vector<geo::Coordinates> &coords, svg::Document &result_doc) {
+  void MapRenderer::RenderSubnetwork(const std::vector<bool> &is_stop_visible, svg::Document &result_doc) {
+    auto is_visible = [this, &is_stop_visible](const Stop *stop) {
+      return is_stop_visible.at(stop->id);
+    };
+
+    std::vector<Bus> sorted_buses(catalogue_.GetAllBuses().begin(), catalogue_.GetAllBuses().end());
+    std::sort(sorted_buses.begin(), sorted_buses.end(),
+              [](const Bus &lhs, const Bus &rhs) { return lhs.name < rhs.name; });
+
+    // Маршрут режется на участки из подряд идущих видимых остановок, каждый участок
+    // рисуется цветом маршрута. Названия - у видимых конечных.
+    std::vector<std::pair<Bus, int>> pieces;
+    std::vector<std::pair<Bus, int>> labels;
+    std::set<std::string_view> visible_stops;
+    std::vector<geo::Coordinates> coords;
+    for (size_t index = 0; index < sorted_buses.size(); ++index) {
+      const Bus &bus = sorted_buses[index];
+      const int color = static_cast<int>(index);
+      Bus piece{bus.name, {}, true};
+      // Остановки участков именно этого маршрута: конечная, нарисованная только другим
+      // маршрутом, не получает его названия
+      std::set<const Stop *> drawn_by_bus;
+      for (size_t position = 0; position <= bus.stops.size(); ++position) {
+        if (position < bus.stops.size() && is_visible(bus.stops[position])) {
+          piece.stops.push_back(bus.stops[position]);
+          continue;
+        }
+        if (piece.stops.size() > 1) {
+          for (const Stop *stop: piece.stops) {
+            visible_stops.insert(stop->name);
+            drawn_by_bus.insert(stop);
+            coords.push_back(stop->coordinates);
+          }
+          pieces.emplace_back(piece, color);
+        }
+        piece.stops.clear();
+      }
+
+      if (bus.stops.empty()) {
+        continue;
+      }
+      Stop *first_terminal = bus.stops.front();
+      Stop *second_terminal = bus.stops[(bus.stops.size() - 1) / 2];
+      const bool is_first_drawn = drawn_by_bus.count(first_terminal) > 0;
+      const bool is_second_drawn = !bus.is_roundtrip && drawn_by_bus.count(second_terminal) > 0;
+      if (is_first_drawn && is_second_drawn) {
+        labels.emplace_back(bus, color);
+      } else if (is_first_drawn || is_second_drawn) {
+        labels.emplace_back(Bus{bus.name, {is_first_drawn ? first_terminal : second_terminal}, true}, color);
+      }
+    }
+
+    for (auto &[piece, color]: pieces) {
+      result_doc.Add(DrawThePolyline(coords, piece, color));
+    }
+    for (auto &[bus, color]: labels) {
+      for (auto &text: DrawRouteNames(coords, bus, color)) {
+        result_doc.Add(std::move(text));
+      }
+    }
+    DrawStops(coords, visible_stops, result_doc);
+    DrawStopNames(coords, visible_stops, result_doc);
+  }
+
+  void MapRenderer::DrawStops(const std::vector<geo::Coordinates> &coords, const std::set<std::string_view> &stops,
+                              svg::Document &result_doc) {
     std::vector<svg::Circle> result;
     auto projector = SphereProjector(coords.begin(), coords.end(), prop_.width, prop_.height, prop_.padding);
 
-    auto all_unique_stops = catalogue_.GetUniqueStops();
-    result.reserve(all_unique_stops.size());
-    for (auto unique_stop: all_unique_stops) {
+    result.reserve(stops.size());
+    for (auto unique_stop: stops) {
       geo::Coordinates coords_of_stop = catalogue_.FindStop(std::string{unique_stop})->coordinates;
       svg::Point pt = projector(coords_of_stop);
       svg::Circle stop;
@@ -112,13 +176,13 @@ namespace transport_catalogue {
     }
   }
 
-  void MapRenderer::DrawStopNames(const std::vector<geo::Coordinates> &coords, svg::Document &result_doc) {
+  void MapRenderer::DrawStopNames(const std::vector<geo::Coordinates> &coords, const std::set<std::string_view> &stops,
+                                  svg::Document &result_doc) {
     std::vector<svg::Text> result;
     auto projector = SphereProjector(coords.begin(), coords.end(), prop_.width, prop_.height, prop_.padding);
 
-    auto all_unique_stops = catalogue_.GetUniqueStops();
-    result.reserve(all_unique_stops.size());
-    for (auto stop: all_unique_stops) {
+    result.reserve(stops.size());
+    for (auto stop: stops) {
       geo::Coordinates coords_of_stop = catalogue_.FindStop(std::string{stop})->coordinates;
       svg::Point pt = projector(coords_of_stop);
 
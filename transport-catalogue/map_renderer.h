@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <set>
+#include <string_view>
 #include <vector>
 #include "svg.h"
 #include "json.h"
@@ -43,12 +45,19 @@ namespace transport_catalogue {
 
     svg::Document& Render();
 
+    // Рисует в result_doc карту только из видимых остановок и участков маршрутов между соседними
+    // видимыми остановками. is_stop_visible индексируется номером остановки, цвета маршрутов те же,
+    // что на полной карте, масштаб подбирается по видимым остановкам.
+    void RenderSubnetwork(const std::vector<bool> &is_stop_visible, svg::Document &result_doc);
+
   private:
     svg::Polyline DrawThePolyline(const std::vector<geo::Coordinates> &coords, const Bus &bus, int &color_iterator);
 
-    void DrawStops(const std::vector<geo::Coordinates> &coords, svg::Document &result_doc);
+    void DrawStops(const std::vector<geo::Coordinates> &coords, const std::set<std::string_view> &stops,
+                   svg::Document &result_doc);
 
-    void DrawStopNames(const std::vector<geo::Coordinates> &coords, svg::Document &result_doc);
+    void DrawStopNames(const std::vector<geo::Coordinates> &coords, const std::set<std::string_view> &stops,
+                       svg::Document &result_doc);
 
     std::vector<svg::Text> DrawRouteNames(const std::vector<geo::Coordinates> &coords, Bus bus, int &color_iterator);
 
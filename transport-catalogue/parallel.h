@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+  // Число потоков по умолчанию: 0 означает "по числу ядер"
+  inline size_t ResolveThreadsCount(size_t threads_count) {
+    if (threads_count != 0) {
+      return threads_count;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Вызывает func(index) для всех index из [0, count). Потоки разбирают индексы
+  // по одному, поэтому задачи разного размера распределяются равномерно.
+  template<typename Func>
+  void ForEachIndex(size_t count, size_t threads_count, Func func) {
+    std::atomic<size_t> next_index = 0;
+    auto worker = [count, &next_index, &func] {
+      for (size_t index = next_index++; index < count; index = next_index++) {
+        func(index);
+      }
+    };
+    const size_t workers_count = std::min(ResolveThreadsCount(threads_count), count);
+    std::vector<std::thread> threads;
+    for (size_t worker_number = 1; worker_number < workers_count; ++worker_number) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread: threads) {
+      thread.join();
+    }
+  }
+
+} // namespace parallel
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+  // Многокритериальный поиск по весу и числу рёбер. В графе маршрутов ребро - одна поездка
+  // с ожиданием, поэтому число рёбер на единицу больше числа пересадок.
+  // Раунд k находит лучшие веса путей не более чем из k рёбер, релаксируя только рёбра из
+  // вершин, улучшенных в прошлом раунде. Метка сохраняется, только если она легче лучших
+  // меток этой вершины и цели из прошлых раундов: остальные доминируются.
+  template<typename Weight>
+  class ParetoRouter {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    static constexpr size_t NO_EDGES_LIMIT = std::numeric_limits<size_t>::max();
+
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    explicit ParetoRouter(const Graph &graph);
+
+    // Парето-оптимальные пути из не более чем max_edges рёбер в порядке увеличения числа
+    // рёбер: каждый следующий путь длиннее по числу рёбер и легче предыдущего.
+    std::vector<RouteInfo> BuildRoutes(VertexId from, VertexId to, size_t max_edges = NO_EDGES_LIMIT) const;
+
+    const Graph &GetGraph() const {
+      return graph_;
+    }
+
+  private:
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                              ? std::numeric_limits<Weight>::infinity()
+                                              : std::numeric_limits<Weight>::max();
+
+    // prev_edges[k][vertex] - последнее ребро пути, улучшившего вершину в раунде k
+    std::vector<EdgeId> ReconstructEdges(const std::vector<std::vector<PrevEdgeId>> &prev_edges,
+                                         VertexId to, size_t round) const;
+
+    const Graph &graph_;
+  };
+
+  template<typename Weight>
+  ParetoRouter<Weight>::ParetoRouter(const Graph &graph) : graph_(graph) {
+    CheckPrevEdgeIdCapacity(graph_.GetEdgeCount());
+  }
+
+  template<typename Weight>
+  std::vector<typename ParetoRouter<Weight>::RouteInfo>
+  ParetoRouter<Weight>::BuildRoutes(VertexId from, VertexId to, size_t max_edges) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+      throw std::out_of_range("Vertex id is out of range");
+    }
+    // weights[k][vertex] - лучший вес пути не более чем из k рёбер
+    std::vector<std::vector<Weight>> weights{std::vector<Weight>(vertex_count, INFINITE_WEIGHT)};
+    std::vector<std::vector<PrevEdgeId>> prev_edges{std::vector<PrevEdgeId>(vertex_count, NO_PREV_EDGE)};
+    weights[0][from] = ZERO_WEIGHT;
+
+    std::vector<VertexId> improved{from};
+    std::vector<bool> is_improved(vertex_count, false);
+    std::vector<VertexId> next_improved;
+    for (size_t round = 1; round <= max_edges && !improved.empty(); ++round) {
+      weights.push_back(weights.back());
+      prev_edges.emplace_back(vertex_count, NO_PREV_EDGE);
+      const auto &previous = weights[round - 1];
+      auto &current = weights[round];
+      for (const VertexId vertex: improved) {
+        for (const EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+          const VertexId target = graph_.GetEdgeTarget(edge_id);
+          const Weight weight = previous[vertex] + graph_.GetEdgeWeight(edge_id);
+          // current уже содержит лучшие веса прошлых раундов
+          if (weight < current[target] && weight < current[to]) {
+            current[target] = weight;
+            prev_edges[round][target] = static_cast<PrevEdgeId>(edge_id);
+            if (!is_improved[target]) {
+              is_improved[target] = true;
+              next_improved.push_back(target);
+            }
+          }
+        }
+      }
+      for (const VertexId vertex: next_improved) {
+        is_improved[vertex] = false;
+      }
+      improved.swap(next_improved);
+      next_improved.clear();
+    }
+
+    std::vector<RouteInfo> result;
+    for (size_t round = 0; round < weights.size(); ++round) {
+      if (weights[round][to] != INFINITE_WEIGHT && (round == 0 || weights[round][to] < weights[round - 1][to])) {
+        result.push_back({weights[round][to], ReconstructEdges(prev_edges, to, round)});
+      }
+    }
+    return result;
+  }
+
+  template<typename Weight>
+  std::vector<EdgeId> ParetoRouter<Weight>::ReconstructEdges(const std::vector<std::vector<PrevEdgeId>> &prev_edges,
+                                                             VertexId to, size_t round) const {
+    std::vector<EdgeId> edges;
+    VertexId vertex = to;
+    while (true) {
+      // Вес вершины мог быть найден в одном из прошлых раундов и просто перенесён
+      while (round > 0 && prev_edges[round][vertex] == NO_PREV_EDGE) {
+        --round;
+      }
+      if (round == 0) {
+        break;
+      }
+      const EdgeId edge_id = prev_edges[round][vertex];
+      edges.push_back(edge_id);
+      vertex = graph_.GetEdgeSource(edge_id);
+      --round;
+    }
+    std::reverse(edges.begin(), edges.end());
+    return edges;
+  }
+
+} // namespace graph
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -34,4 +35,49 @@ namespace ranges {
     return Range{container.begin(), container.end()};
   }
 
+  // Итератор по последовательным целым числам, не требующий хранения контейнера
+  template<typename Integer>
+  class IndexIterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Integer;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Integer *;
+    using reference = Integer;
+
+    explicit IndexIterator(Integer value) : value_(value) {
+    }
+
+    Integer operator*() const {
+      return value_;
+    }
+
+    IndexIterator &operator++() {
+      ++value_;
+      return *this;
+    }
+
+    IndexIterator operator++(int) {
+      IndexIterator result = *this;
+      ++value_;
+      return result;
+    }
+
+    bool operator==(const IndexIterator &other) const {
+      return value_ == other.value_;
+    }
+
+    bool operator!=(const IndexIterator &other) const {
+      return value_ != other.value_;
+    }
+
+  private:
+    Integer value_;
+  };
+
+  template<typename Integer>
+  auto AsIndexRange(Integer begin, Integer end) {
+    return Range{IndexIterator<Integer>{begin}, IndexIterator<Integer>{end}};
+  }
+
 }  // namespace ranges
\ No newline at end of file
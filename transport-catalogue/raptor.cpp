@@ -0,0 +1,211 @@
+#include "raptor.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace raptor {
+
+  Router::Router(size_t stops_count, std::vector<Pattern> patterns, double bus_wait_time, double bus_velocity)
+      : stops_count_(stops_count), patterns_(std::move(patterns)), bus_wait_time_(bus_wait_time),
+        bus_velocity_(bus_velocity) {
+    // Индекс остановка -> вхождения в маршруты раскладывается подсчётом, как рёбра в графе
+    stop_offsets_.assign(stops_count_ + 1, 0);
+    for (const auto &pattern: patterns_) {
+      if (pattern.stops.size() != pattern.distances.size()) {
+        throw std::invalid_argument("Pattern stops and distances differ in size");
+      }
+      for (const StopId stop: pattern.stops) {
+        CheckStop(stop);
+        ++stop_offsets_[stop + 1];
+      }
+    }
+    for (size_t stop = 0; stop < stops_count_; ++stop) {
+      stop_offsets_[stop + 1] += stop_offsets_[stop];
+    }
+    stop_patterns_.resize(stop_offsets_.back());
+    std::vector<size_t> next(stop_offsets_.begin(), stop_offsets_.end() - 1);
+    for (size_t pattern = 0; pattern < patterns_.size(); ++pattern) {
+      const auto &stops = patterns_[pattern].stops;
+      for (size_t position = 0; position < stops.size(); ++position) {
+        stop_patterns_[next[stops[position]]++] = {pattern, position};
+      }
+    }
+  }
+
+  std::optional<Journey> Router::BuildRoute(StopId from, StopId to) const {
+    const SearchResult result = Search(from, to, NO_LEGS_LIMIT);
+    const double best = result.arrivals.back()[to];
+    if (best == INF) {
+      return std::nullopt;
+    }
+    // Прибытие обновляется только при строгом улучшении, поэтому первый раунд
+    // с лучшим временем даёт маршрут с наименьшим числом поездок
+    size_t round = 0;
+    while (result.arrivals[round][to] != best) {
+      ++round;
+    }
+    return ExtractJourney(result, to, round);
+  }
+
+  std::vector<Journey> Router::BuildRoutesByLegs(StopId from, StopId to, size_t max_legs) const {
+    const SearchResult result = Search(from, to, max_legs);
+    std::vector<Journey> journeys;
+    double previous = INF;
+    for (size_t round = 0; round < result.arrivals.size(); ++round) {
+      if (result.arrivals[round][to] < previous) {
+        previous = result.arrivals[round][to];
+        journeys.push_back(ExtractJourney(result, to, round));
+      }
+    }
+    return journeys;
+  }
+
+  std::vector<std::pair<StopId, double>> Router::BuildReachable(StopId from, double max_time) const {
+    std::vector<std::pair<StopId, double>> result;
+    if (max_time < 0) {
+      CheckStop(from);
+      return result;
+    }
+    const SearchResult search_result = Search(from, std::nullopt, NO_LEGS_LIMIT, max_time);
+    const auto &arrivals = search_result.arrivals.back();
+    for (StopId stop = 0; stop < stops_count_; ++stop) {
+      if (arrivals[stop] != INF) {
+        result.emplace_back(stop, arrivals[stop]);
+      }
+    }
+    return result;
+  }
+
+  std::vector<std::optional<double>> Router::BuildWeights(StopId from, const std::vector<StopId> &targets) const {
+    for (const StopId target: targets) {
+      CheckStop(target);
+    }
+    const SearchResult result = Search(from, std::nullopt, NO_LEGS_LIMIT);
+    std::vector<std::optional<double>> weights;
+    weights.reserve(targets.size());
+    for (const StopId target: targets) {
+      const double arrival = result.arrivals.back()[target];
+      weights.push_back(arrival == INF ? std::nullopt : std::optional<double>(arrival));
+    }
+    return weights;
+  }
+
+  Router::SearchResult Router::Search(StopId from, std::optional<StopId> target, size_t max_legs,
+                                      double max_arrival) const {
+    CheckStop(from);
+    if (target) {
+      CheckStop(*target);
+    }
+    SearchResult result;
+    result.arrivals.emplace_back(stops_count_, INF);
+    result.boardings.emplace_back(stops_count_);
+    result.arrivals[0][from] = 0;
+
+    // Лучшее время прибытия по всем раундам: новое прибытие сохраняется, только если оно раньше
+    std::vector<double> best(stops_count_, INF);
+    best[from] = 0;
+    std::vector<StopId> marked_stops{from};
+    std::vector<bool> is_marked(stops_count_, false);
+    // Для каждого маршрута - самая ранняя позиция остановки, улучшенной в прошлом раунде
+    std::vector<size_t> first_position(patterns_.size(), NONE);
+    std::vector<size_t> touched_patterns;
+
+    for (size_t round = 1; round <= max_legs && !marked_stops.empty(); ++round) {
+      for (const StopId stop: marked_stops) {
+        is_marked[stop] = false;
+        for (size_t index = stop_offsets_[stop]; index < stop_offsets_[stop + 1]; ++index) {
+          const auto [pattern, position] = stop_patterns_[index];
+          if (first_position[pattern] == NONE) {
+            touched_patterns.push_back(pattern);
+          }
+          first_position[pattern] = std::min(first_position[pattern], position);
+        }
+      }
+      marked_stops.clear();
+
+      result.arrivals.push_back(result.arrivals.back());
+      result.boardings.emplace_back(stops_count_);
+      const auto &previous = result.arrivals[round - 1];
+      auto &current = result.arrivals[round];
+      auto &boardings = result.boardings[round];
+
+      for (const size_t pattern: touched_patterns) {
+        const auto &stops = patterns_[pattern].stops;
+        const auto &distances = patterns_[pattern].distances;
+        // Время прибытия на позицию j после посадки на позиции i равно
+        // previous[i] + wait + (distances[j] - distances[i]) / velocity, поэтому лучшая
+        // посадка выбирается по previous[i] - distances[i] / velocity за один проход
+        double board_key = INF;
+        size_t board_position = NONE;
+        for (size_t position = first_position[pattern]; position < stops.size(); ++position) {
+          const StopId stop = stops[position];
+          if (board_position != NONE) {
+            const double arrival = previous[stops[board_position]]
+                                   + MakeLeg(pattern, board_position, position).weight;
+            const double bound = target ? std::min(best[stop], best[*target]) : best[stop];
+            if (arrival < bound && arrival <= max_arrival) {
+              current[stop] = arrival;
+              best[stop] = arrival;
+              boardings[stop] = {pattern, board_position, position};
+              if (!is_marked[stop]) {
+                is_marked[stop] = true;
+                marked_stops.push_back(stop);
+              }
+            }
+          }
+          if (previous[stop] != INF) {
+            const double key = previous[stop] - distances[position] / bus_velocity_;
+            if (key < board_key) {
+              board_key = key;
+              board_position = position;
+            }
+          }
+        }
+        first_position[pattern] = NONE;
+      }
+      touched_patterns.clear();
+    }
+    return result;
+  }
+
+  Journey Router::ExtractJourney(const SearchResult &result, StopId to, size_t round) const {
+    Journey journey{0, {}};
+    StopId stop = to;
+    while (true) {
+      // Прибытие могло быть найдено в одном из прошлых раундов и просто перенесено
+      while (round > 0 && result.boardings[round][stop].pattern == NONE) {
+        --round;
+      }
+      if (round == 0) {
+        break;
+      }
+      const Boarding &boarding = result.boardings[round][stop];
+      journey.legs.push_back(MakeLeg(boarding.pattern, boarding.board_position, boarding.alight_position));
+      stop = journey.legs.back().from;
+      --round;
+    }
+    std::reverse(journey.legs.begin(), journey.legs.end());
+    // Время суммируется в порядке поездок, как при поиске по графу
+    for (const Leg &leg: journey.legs) {
+      journey.total_time += leg.weight;
+    }
+    return journey;
+  }
+
+  Leg Router::MakeLeg(size_t pattern, size_t board_position, size_t alight_position) const {
+    const Pattern &current = patterns_[pattern];
+    const double total_dist = current.distances[alight_position] - current.distances[board_position];
+    return {current.stops[board_position],
+            current.stops[alight_position],
+            bus_wait_time_ + total_dist / bus_velocity_ * 1.0,
+            current.bus_id,
+            static_cast<int>(alight_position - board_position)};
+  }
+
+  void Router::CheckStop(StopId stop) const {
+    if (stop >= stops_count_) {
+      throw std::out_of_range("Stop id is out of range");
+    }
+  }
+
+} // namespace raptor
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace raptor {
+
+  using StopId = size_t;
+
+  // Остановки, которые автобус проезжает подряд в одном направлении
+  struct Pattern {
+    uint32_t bus_id;
+    std::vector<StopId> stops;
+    // distances[i] - дорожное расстояние от первой остановки до i-й
+    std::vector<int64_t> distances;
+  };
+
+  // Одна поездка: ожидание на остановке from и проезд до to без пересадок
+  using Leg = graph::Edge<double>;
+
+  struct Journey {
+    double total_time;
+    std::vector<Leg> legs;
+  };
+
+  // Поиск по раундам (RAPTOR) прямо по последовательностям остановок, без графа
+  // со всеми парами остановок маршрута. Раунд k находит лучшие времена прибытия не более
+  // чем с k поездками, время раунда линейно по суммарной длине маршрутов.
+  class Router {
+  public:
+    static constexpr size_t NO_LEGS_LIMIT = std::numeric_limits<size_t>::max();
+
+    // Поездка от i-й до j-й остановки маршрута занимает bus_wait_time + расстояние / bus_velocity
+    Router(size_t stops_count, std::vector<Pattern> patterns, double bus_wait_time, double bus_velocity);
+
+    size_t GetStopsCount() const {
+      return stops_count_;
+    }
+
+    // Самый быстрый маршрут, из равных по времени - с наименьшим числом поездок
+    std::optional<Journey> BuildRoute(StopId from, StopId to) const;
+
+    // Самые быстрые маршруты для каждого возможного числа поездок до max_legs включительно:
+    // каждый следующий использует больше поездок и приезжает раньше предыдущего.
+    // Первый маршрут - с минимальным числом пересадок.
+    std::vector<Journey> BuildRoutesByLegs(StopId from, StopId to, size_t max_legs = NO_LEGS_LIMIT) const;
+
+    // Остановки, до которых можно доехать не более чем за max_time, со временем в пути
+    std::vector<std::pair<StopId, double>> BuildReachable(StopId from, double max_time) const;
+
+    // Время в пути от from до каждой из targets, nullopt - цель недостижима
+    std::vector<std::optional<double>> BuildWeights(StopId from, const std::vector<StopId> &targets) const;
+
+  private:
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    // Вхождение остановки в маршрут
+    struct PatternStop {
+      size_t pattern;
+      size_t position;
+    };
+
+    // Поездка, улучшившая время прибытия на остановку в своём раунде
+    struct Boarding {
+      size_t pattern = NONE;
+      size_t board_position = 0;
+      size_t alight_position = 0;
+    };
+
+    struct SearchResult {
+      // arrivals[k][stop] - лучшее время прибытия не более чем с k поездками
+      std::vector<std::vector<double>> arrivals;
+      std::vector<std::vector<Boarding>> boardings;
+    };
+
+    // target ограничивает поиск: не сохраняются прибытия не раньше лучшего прибытия в target.
+    // Прибытия позже max_arrival тоже не сохраняются.
+    SearchResult Search(StopId from, std::optional<StopId> target, size_t max_legs,
+                        double max_arrival = INF) const;
+
+    Journey ExtractJourney(const SearchResult &result, StopId to, size_t round) const;
+
+    Leg MakeLeg(size_t pattern, size_t board_position, size_t alight_position) const;
+
+    void CheckStop(StopId stop) const;
+
+    size_t stops_count_;
+    std::vector<Pattern> patterns_;
+    // Вхождения в маршруты для каждой остановки: stop_patterns_[stop_offsets_[s]..stop_offsets_[s + 1])
+    std::vector<size_t> stop_offsets_;
+    std::vector<PatternStop> stop_patterns_;
+    double bus_wait_time_;
+    double bus_velocity_;
+  };
+
+} // namespace raptor
@@ -0,0 +1,29 @@
+#include "route_cache.h"
+
+namespace transport_catalogue {
+
+  RouteCache::RouteCache(size_t capacity) : entries_(capacity) {
+  }
+
+  void RouteCache::Validate(uint64_t catalogue_version, uint64_t router_version) {
+    const std::pair versions{catalogue_version, router_version};
+    if (versions_ != versions) {
+      entries_.Clear();
+      versions_ = versions;
+    }
+  }
+
+  std::optional<RouteCache::Value> RouteCache::Get(Key key) {
+    if (const Value *value = entries_.Get(key)) {
+      ++hits_;
+      return *value;
+    }
+    ++misses_;
+    return std::nullopt;
+  }
+
+  void RouteCache::Put(Key key, Value value) {
+    entries_.Put(key, std::move(value));
+  }
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "json.h"
+#include "lru_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace transport_catalogue {
+
+  // Готовая часть ответа на запрос Route
+  struct SerializedRoute {
+    double total_time;
+    json::Array items;
+  };
+
+  // Ограниченный кэш ответов Route по паре номеров остановок. Ответы действительны только
+  // для той версии справочника и роутера, для которой построены: при смене версии кэш очищается.
+  class RouteCache {
+  public:
+    using Key = std::pair<size_t, size_t>;
+    // Записи неизменяемы и разделяются с ответами без копирования.
+    // nullptr - маршрут не найден, такой ответ тоже кэшируется
+    using Value = std::shared_ptr<const SerializedRoute>;
+
+    explicit RouteCache(size_t capacity);
+
+    // Вызывается перед обращениями к кэшу с текущими версиями данных
+    void Validate(uint64_t catalogue_version, uint64_t router_version);
+
+    // nullopt - ответа нет в кэше
+    std::optional<Value> Get(Key key);
+
+    void Put(Key key, Value value);
+
+    // Число обращений к Get, нашедших и не нашедших ответ, за всё время работы кэша
+    size_t GetHits() const {
+      return hits_;
+    }
+
+    size_t GetMisses() const {
+      return misses_;
+    }
+
+  private:
+    struct KeyHasher {
+      size_t operator()(Key key) const {
+        return std::hash<size_t>{}(key.first) * 37 + std::hash<size_t>{}(key.second);
+      }
+    };
+
+    cache::LruCache<Key, Value, KeyHasher> entries_;
+    std::optional<std::pair<uint64_t, uint64_t>> versions_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+  };
+
+}
@@ -1,12 +1,18 @@
 #pragma once
 
 #include "graph.h"
+#include "lru_cache.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -14,13 +20,91 @@
 
 namespace graph {
 
+  // Ребро-предшественник в компактных таблицах маршрутов: 32 бита вместо optional<EdgeId>
+  using PrevEdgeId = uint32_t;
+  inline constexpr PrevEdgeId NO_PREV_EDGE = std::numeric_limits<PrevEdgeId>::max();
+
+  // Проверяет, что идентификаторы рёбер графа помещаются в PrevEdgeId
+  inline void CheckPrevEdgeIdCapacity(size_t edge_count) {
+    if (edge_count >= NO_PREV_EDGE) {
+      throw std::length_error("Too many edges for 32-bit edge ids");
+    }
+  }
+
+  // Описание изменения графа, по которому кэшированные деревья поправляются, а не строятся заново
+  struct GraphChanges {
+    static constexpr EdgeId NO_EDGE = graph::NO_EDGE;
+
+    // Новый идентификатор каждого старого ребра, NO_EDGE - ребро удалено
+    std::vector<EdgeId> new_edge_ids;
+    // Старые идентификаторы удалённых рёбер и рёбер, вес которых увеличился
+    std::vector<EdgeId> worsened_edges;
+    // Новые идентификаторы добавленных рёбер и рёбер, вес которых уменьшился
+    std::vector<EdgeId> improved_edges;
+  };
+
+  struct SearchStats {
+    // Число вершин, извлечённых из очереди с окончательным расстоянием
+    size_t settled_vertices = 0;
+  };
+
+  // Нулевая оценка превращает A* в обычный поиск Дейкстры между двумя вершинами
+  template<typename Weight>
+  struct ZeroHeuristic {
+    Weight operator()(VertexId) const {
+      return {};
+    }
+  };
+
+  // Вершины, достижимые из from путём веса не больше max_weight, с весами кратчайших путей
+  // в порядке возрастания веса. Поиск Дейкстры останавливается на первой вершине дальше max_weight.
+  template<typename Weight>
+  std::vector<std::pair<VertexId, Weight>> BuildReachableVertices(const DirectedWeightedGraph<Weight> &graph,
+                                                                  VertexId from, Weight max_weight) {
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    const size_t vertex_count = graph.GetVertexCount();
+    if (from >= vertex_count) {
+      throw std::out_of_range("Vertex id is out of range");
+    }
+    std::vector<std::pair<VertexId, Weight>> result;
+    if (max_weight < Weight{}) {
+      return result;
+    }
+    std::vector<std::optional<Weight>> weights(vertex_count);
+    std::vector<bool> settled(vertex_count, false);
+    weights[from] = Weight{};
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+    queue.push({Weight{}, from});
+    while (!queue.empty()) {
+      const auto [weight, vertex] = queue.top();
+      queue.pop();
+      if (settled[vertex]) {
+        continue;
+      }
+      settled[vertex] = true;
+      result.emplace_back(vertex, weight);
+      for (const EdgeId edge_id: graph.GetIncidentEdges(vertex)) {
+        const VertexId target = graph.GetEdgeTarget(edge_id);
+        const Weight candidate_weight = weight + graph.GetEdgeWeight(edge_id);
+        if (!(max_weight < candidate_weight) && (!weights[target] || candidate_weight < *weights[target])) {
+          weights[target] = candidate_weight;
+          queue.push({candidate_weight, target});
+        }
+      }
+    }
+    return result;
+  }
+
   template<typename Weight>
   class Router {
   private:
     using Graph = DirectedWeightedGraph<Weight>;
 
   public:
-    explicit Router(const Graph &graph);
+    static constexpr size_t DEFAULT_CACHE_CAPACITY = 256;
+
+    explicit Router(const Graph &graph, size_t cache_capacity = DEFAULT_CACHE_CAPACITY);
 
     struct RouteInfo {
       Weight weight;
@@ -29,90 +113,344 @@ namespace graph {
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
-    const Graph &GetGraph() {
+    // Поиск A* от from до to без использования кэша деревьев. heuristic(vertex) должна
+    // быть допустимой и монотонной нижней оценкой веса пути от vertex до to.
+    template<typename Heuristic>
+    std::optional<RouteInfo> BuildRouteAStar(VertexId from, VertexId to, Heuristic heuristic,
+                                             SearchStats *stats = nullptr) const;
+
+    // Веса кратчайших путей от from до каждой из вершин targets без восстановления путей.
+    // Поиск не использует кэш деревьев и останавливается, когда просмотрены все targets.
+    std::vector<std::optional<Weight>> BuildWeights(VertexId from, const std::vector<VertexId> &targets) const;
+
+    const Graph &GetGraph() const {
       return graph_;
     }
 
+    // Вызывается после того, как граф, на который ссылается роутер, изменён на месте.
+    // Кэшированные деревья исправляются: пересчитываются только вершины, путь к которым
+    // шёл через ухудшившиеся рёбра, и вершины, до которых улучшенные рёбра дают путь короче.
+    // Не совместим с параллельными запросами.
+    void ApplyGraphChanges(const GraphChanges &changes);
+
   private:
+    // Недостижимая вершина имеет вес INFINITE_WEIGHT, у источника нет предшественника
     struct RouteInternalData {
       Weight weight;
-      std::optional<EdgeId> prev_edge;
+      PrevEdgeId prev_edge;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    // Дерево кратчайших путей из одной вершины-источника, одно выделение памяти на дерево
+    using RoutesInternalData = std::vector<RouteInternalData>;
+    using RoutesInternalDataPtr = std::shared_ptr<const RoutesInternalData>;
 
-    void InitializeRoutesInternalData(const Graph &graph) {
-      const size_t vertex_count = graph.GetVertexCount();
-      for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-        routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-        for (const EdgeId edge_id: graph.GetIncidentEdges(vertex)) {
-          const auto &edge = graph.GetEdge(edge_id);
-          if (edge.weight < ZERO_WEIGHT) {
-            throw std::domain_error("Edges' weights should be non-negative");
-          }
-          auto &route_internal_data = routes_internal_data_[vertex][edge.to];
-          if (!route_internal_data || route_internal_data->weight > edge.weight) {
-            route_internal_data = RouteInternalData{edge.weight, edge_id};
-          }
+    RoutesInternalDataPtr GetRoutesInternalData(VertexId from) const;
+
+    RoutesInternalData BuildRoutesInternalData(VertexId from) const;
+
+    std::vector<EdgeId> ReconstructEdges(const RoutesInternalData &routes_internal_data, VertexId to) const;
+
+    void RepairRoutesInternalData(RoutesInternalData &tree, const GraphChanges &changes,
+                                  const std::vector<bool> &is_worsened) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                              ? std::numeric_limits<Weight>::infinity()
+                                              : std::numeric_limits<Weight>::max();
+    const Graph &graph_;
+    mutable std::mutex cache_mutex_;
+    mutable cache::LruCache<VertexId, RoutesInternalDataPtr> trees_cache_;
+  };
+
+  template<typename Weight>
+  Router<Weight>::Router(const Graph &graph, size_t cache_capacity)
+      : graph_(graph), trees_cache_(cache_capacity) {
+    CheckPrevEdgeIdCapacity(graph.GetEdgeCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+      if (graph.GetEdgeWeight(edge_id) < ZERO_WEIGHT) {
+        throw std::domain_error("Edges' weights should be non-negative");
+      }
+    }
+  }
+
+  template<typename Weight>
+  typename Router<Weight>::RoutesInternalData Router<Weight>::BuildRoutesInternalData(VertexId from) const {
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    RoutesInternalData routes_internal_data(graph_.GetVertexCount(), {INFINITE_WEIGHT, NO_PREV_EDGE});
+    routes_internal_data.at(from).weight = ZERO_WEIGHT;
+
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+    queue.push({ZERO_WEIGHT, from});
+    while (!queue.empty()) {
+      const auto [weight, vertex] = queue.top();
+      queue.pop();
+      // В очереди могли остаться устаревшие записи о вершине
+      if (routes_internal_data[vertex].weight < weight) {
+        continue;
+      }
+      for (const EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+        const VertexId target = graph_.GetEdgeTarget(edge_id);
+        const Weight candidate_weight = weight + graph_.GetEdgeWeight(edge_id);
+        auto &route_internal_data = routes_internal_data[target];
+        if (candidate_weight < route_internal_data.weight) {
+          route_internal_data = RouteInternalData{candidate_weight, static_cast<PrevEdgeId>(edge_id)};
+          queue.push({candidate_weight, target});
         }
       }
     }
+    return routes_internal_data;
+  }
+
+  template<typename Weight>
+  typename Router<Weight>::RoutesInternalDataPtr Router<Weight>::GetRoutesInternalData(VertexId from) const {
+    {
+      std::lock_guard guard(cache_mutex_);
+      if (auto cached = trees_cache_.Get(from)) {
+        return *cached;
+      }
+    }
+    // Поиск выполняется без блокировки, чтобы не задерживать запросы из других источников
+    auto routes_internal_data = std::make_shared<const RoutesInternalData>(BuildRoutesInternalData(from));
+    std::lock_guard guard(cache_mutex_);
+    trees_cache_.Put(from, routes_internal_data);
+    return routes_internal_data;
+  }
+
+  template<typename Weight>
+  std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
+                                                                               VertexId to) const {
+    const auto routes_internal_data = GetRoutesInternalData(from);
+    const Weight weight = routes_internal_data->at(to).weight;
+    if (!(weight < INFINITE_WEIGHT)) {
+      return std::nullopt;
+    }
+    return RouteInfo{weight, ReconstructEdges(*routes_internal_data, to)};
+  }
+
+  template<typename Weight>
+  void Router<Weight>::ApplyGraphChanges(const GraphChanges &changes) {
+    CheckPrevEdgeIdCapacity(graph_.GetEdgeCount());
+    std::vector<bool> is_worsened(changes.new_edge_ids.size(), false);
+    for (const EdgeId edge_id: changes.worsened_edges) {
+      is_worsened.at(edge_id) = true;
+    }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData &route_from,
-                    const RouteInternalData &route_to) {
-      auto &route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-      const Weight candidate_weight = route_from.weight + route_to.weight;
-      if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-        route_relaxing = {candidate_weight,
-                          route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    std::lock_guard guard(cache_mutex_);
+    trees_cache_.UpdateAll([&](VertexId, RoutesInternalDataPtr &routes_internal_data) {
+      if (routes_internal_data->size() != graph_.GetVertexCount()) {
+        return false;
       }
+      // Кэшированные деревья неизменяемы, поэтому дерево заменяется исправленной копией
+      RoutesInternalData tree(*routes_internal_data);
+      RepairRoutesInternalData(tree, changes, is_worsened);
+      routes_internal_data = std::make_shared<const RoutesInternalData>(std::move(tree));
+      return true;
+    });
+  }
+
+  template<typename Weight>
+  void Router<Weight>::RepairRoutesInternalData(RoutesInternalData &tree, const GraphChanges &changes,
+                                                const std::vector<bool> &is_worsened) const {
+    using QueueItem = std::pair<Weight, VertexId>;
+    enum class State : uint8_t { UNKNOWN, VALID, INVALID };
+
+    // Вершина теряет путь, если он проходит по ухудшившемуся ребру: такие вершины
+    // образуют поддеревья под этими рёбрами. Остальные рёбра дерева переименовываются.
+    const size_t vertex_count = tree.size();
+    std::vector<State> states(vertex_count, State::UNKNOWN);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      PrevEdgeId &prev_edge = tree[vertex].prev_edge;
+      if (prev_edge == NO_PREV_EDGE) {
+        states[vertex] = State::VALID;
+      } else if (is_worsened[prev_edge]) {
+        states[vertex] = State::INVALID;
+      } else {
+        prev_edge = static_cast<PrevEdgeId>(changes.new_edge_ids[prev_edge]);
+      }
+    }
+    std::vector<VertexId> path;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      VertexId current = vertex;
+      while (states[current] == State::UNKNOWN) {
+        path.push_back(current);
+        current = graph_.GetEdgeSource(tree[current].prev_edge);
+      }
+      for (const VertexId path_vertex: path) {
+        states[path_vertex] = states[current];
+      }
+      path.clear();
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-      for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-        if (const auto &route_from = routes_internal_data_[vertex_from][vertex_through]) {
-          for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-            if (const auto &route_to = routes_internal_data_[vertex_through][vertex_to]) {
-              RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-            }
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+    auto relax = [&tree, &queue, this](EdgeId edge_id, Weight source_weight) {
+      const VertexId target = graph_.GetEdgeTarget(edge_id);
+      const Weight candidate_weight = source_weight + graph_.GetEdgeWeight(edge_id);
+      if (candidate_weight < tree[target].weight) {
+        tree[target] = RouteInternalData{candidate_weight, static_cast<PrevEdgeId>(edge_id)};
+        queue.push({candidate_weight, target});
+      }
+    };
+
+    bool has_invalid = false;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      if (states[vertex] == State::INVALID) {
+        tree[vertex] = RouteInternalData{INFINITE_WEIGHT, NO_PREV_EDGE};
+        has_invalid = true;
+      }
+    }
+    // Потерявшие путь вершины получают кандидатов через рёбра из сохранившейся части дерева
+    if (has_invalid) {
+      for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (states[vertex] != State::VALID || !(tree[vertex].weight < INFINITE_WEIGHT)) {
+          continue;
+        }
+        for (const EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+          if (states[graph_.GetEdgeTarget(edge_id)] == State::INVALID) {
+            relax(edge_id, tree[vertex].weight);
           }
         }
       }
     }
+    for (const EdgeId edge_id: changes.improved_edges) {
+      const Weight source_weight = tree[graph_.GetEdgeSource(edge_id)].weight;
+      if (source_weight < INFINITE_WEIGHT) {
+        relax(edge_id, source_weight);
+      }
+    }
 
-    static constexpr Weight ZERO_WEIGHT{};
-    const Graph &graph_;
-    RoutesInternalData routes_internal_data_;
-  };
+    // Дейкстра распространяет улучшения только по затронутой части дерева
+    while (!queue.empty()) {
+      const auto [weight, vertex] = queue.top();
+      queue.pop();
+      if (tree[vertex].weight < weight) {
+        continue;
+      }
+      for (const EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+        relax(edge_id, weight);
+      }
+    }
+  }
 
   template<typename Weight>
-  Router<Weight>::Router(const Graph &graph)
-      : graph_(graph), routes_internal_data_(graph.GetVertexCount(),
-                                             std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount())) {
-    InitializeRoutesInternalData(graph);
-
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-      RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+  std::vector<EdgeId> Router<Weight>::ReconstructEdges(const RoutesInternalData &routes_internal_data,
+                                                       VertexId to) const {
+    std::vector<EdgeId> edges;
+    for (PrevEdgeId edge_id = routes_internal_data[to].prev_edge;
+         edge_id != NO_PREV_EDGE;
+         edge_id = routes_internal_data[graph_.GetEdgeSource(edge_id)].prev_edge) {
+      edges.push_back(edge_id);
     }
+    std::reverse(edges.begin(), edges.end());
+    return edges;
   }
 
   template<typename Weight>
-  std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                               VertexId to) const {
-    const auto &route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+  template<typename Heuristic>
+  std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRouteAStar(VertexId from, VertexId to,
+                                                                                    Heuristic heuristic,
+                                                                                    SearchStats *stats) const {
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    const size_t vertex_count = graph_.GetVertexCount();
+    RoutesInternalData routes_internal_data(vertex_count, {INFINITE_WEIGHT, NO_PREV_EDGE});
+    std::vector<bool> settled(vertex_count, false);
+    // Оценка для каждой вершины вычисляется не более одного раза за запрос
+    std::vector<std::optional<Weight>> estimates(vertex_count);
+    auto estimate = [&estimates, &heuristic](VertexId vertex) {
+      auto &result = estimates[vertex];
+      if (!result) {
+        result = heuristic(vertex);
+      }
+      return *result;
+    };
+
+    if (from >= vertex_count || to >= vertex_count) {
+      throw std::out_of_range("Vertex id is out of range");
+    }
+    routes_internal_data[from].weight = ZERO_WEIGHT;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+    queue.push({estimate(from), from});
+    size_t settled_count = 0;
+    while (!queue.empty()) {
+      const VertexId vertex = queue.top().second;
+      queue.pop();
+      if (settled[vertex]) {
+        continue;
+      }
+      settled[vertex] = true;
+      ++settled_count;
+      if (vertex == to) {
+        break;
+      }
+      const Weight weight = routes_internal_data[vertex].weight;
+      for (const EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+        const VertexId target = graph_.GetEdgeTarget(edge_id);
+        if (settled[target]) {
+          continue;
+        }
+        const Weight candidate_weight = weight + graph_.GetEdgeWeight(edge_id);
+        auto &route_internal_data = routes_internal_data[target];
+        if (candidate_weight < route_internal_data.weight) {
+          route_internal_data = RouteInternalData{candidate_weight, static_cast<PrevEdgeId>(edge_id)};
+          queue.push({candidate_weight + estimate(target), target});
+        }
+      }
+    }
+    if (stats) {
+      stats->settled_vertices = settled_count;
+    }
+
+    if (!settled[to]) {
       return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
-      edges.push_back(*edge_id);
+    return RouteInfo{routes_internal_data[to].weight, ReconstructEdges(routes_internal_data, to)};
+  }
+
+  template<typename Weight>
+  std::vector<std::optional<Weight>> Router<Weight>::BuildWeights(VertexId from,
+                                                                  const std::vector<VertexId> &targets) const {
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+      throw std::out_of_range("Vertex id is out of range");
+    }
+    // Число вхождений вершины в targets: одна вершина может быть запрошена несколько раз
+    std::vector<size_t> target_counts(vertex_count, 0);
+    for (const VertexId target: targets) {
+      ++target_counts.at(target);
     }
-    std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{weight, std::move(edges)};
+    std::vector<std::optional<Weight>> weights(vertex_count);
+    std::vector<bool> settled(vertex_count, false);
+    weights[from] = ZERO_WEIGHT;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+    queue.push({ZERO_WEIGHT, from});
+    size_t targets_left = targets.size();
+    while (!queue.empty() && targets_left > 0) {
+      const auto [weight, vertex] = queue.top();
+      queue.pop();
+      if (settled[vertex]) {
+        continue;
+      }
+      settled[vertex] = true;
+      targets_left -= target_counts[vertex];
+      for (const EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+        const VertexId target = graph_.GetEdgeTarget(edge_id);
+        const Weight candidate_weight = weight + graph_.GetEdgeWeight(edge_id);
+        if (!weights[target] || candidate_weight < *weights[target]) {
+          weights[target] = candidate_weight;
+          queue.push({candidate_weight, target});
+        }
+      }
+    }
+
+    std::vector<std::optional<Weight>> result;
+    result.reserve(targets.size());
+    for (const VertexId target: targets) {
+      result.push_back(settled[target] ? weights[target] : std::nullopt);
+    }
+    return result;
   }
 
-} // namespace graph
\ No newline at end of file
+} // namespace graph
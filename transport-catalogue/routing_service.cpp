@@ -0,0 +1,40 @@
+#include "routing_service.h"
+
+RoutingService::RoutingService(const transport_catalogue::TransportCatalogue &catalogue,
+                               const RoutingSettings &settings, size_t route_cache_capacity)
+    : catalogue_(catalogue), settings_(settings),
+      router_(std::make_unique<TransportRouter>(catalogue_, settings_)),
+      catalogue_version_(catalogue_.GetVersion()), route_cache_(route_cache_capacity) {
+}
+
+RoutingService::RoutingService(const transport_catalogue::TransportCatalogue &catalogue,
+                               const RoutingSettings &settings, TransportRouter::Data data,
+                               size_t route_cache_capacity)
+    : catalogue_(catalogue), settings_(settings),
+      router_(std::make_unique<TransportRouter>(catalogue_, settings_, std::move(data))),
+      catalogue_version_(catalogue_.GetVersion()), route_cache_(route_cache_capacity) {
+}
+
+const TransportRouter &RoutingService::GetRouter() {
+  if (catalogue_version_ != catalogue_.GetVersion()) {
+    // Справочник изменён в обход сервиса: изменения неизвестны, роутер строится заново
+    router_ = std::make_unique<TransportRouter>(catalogue_, settings_);
+    catalogue_version_ = catalogue_.GetVersion();
+  }
+  return *router_;
+}
+
+void RoutingService::UpdateBus(size_t bus_id) {
+  router_->UpdateBus(bus_id);
+  catalogue_version_ = catalogue_.GetVersion();
+}
+
+void RoutingService::RemoveBus(size_t bus_id) {
+  router_->RemoveBus(bus_id);
+  catalogue_version_ = catalogue_.GetVersion();
+}
+
+void RoutingService::UpdateDistance(graph::VertexId from, graph::VertexId to) {
+  router_->UpdateDistance(from, to);
+  catalogue_version_ = catalogue_.GetVersion();
+}
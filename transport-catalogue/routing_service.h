@@ -0,0 +1,45 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include "route_cache.h"
+
+#include <cstdint>
+#include <memory>
+
+// Владеет роутером и кэшем ответов для одного справочника. Роутер строится один раз и
+// перестраивается, только если справочник изменился не через методы сервиса.
+// Все потребители получают ссылку на один и тот же роутер без копирования графа.
+class RoutingService {
+public:
+  RoutingService(const transport_catalogue::TransportCatalogue &catalogue, const RoutingSettings &settings,
+                 size_t route_cache_capacity);
+
+  // Восстанавливает роутер из ранее построенных данных
+  RoutingService(const transport_catalogue::TransportCatalogue &catalogue, const RoutingSettings &settings,
+                 TransportRouter::Data data, size_t route_cache_capacity);
+
+  // Роутер для текущей версии справочника
+  const TransportRouter &GetRouter();
+
+  transport_catalogue::RouteCache &GetRouteCache() {
+    return route_cache_;
+  }
+
+  // Инкрементальные изменения маршрутов, см. TransportRouter. После них роутер
+  // считается соответствующим текущей версии справочника.
+
+  void UpdateBus(size_t bus_id);
+
+  void RemoveBus(size_t bus_id);
+
+  void UpdateDistance(graph::VertexId from, graph::VertexId to);
+
+private:
+  const transport_catalogue::TransportCatalogue &catalogue_;
+  RoutingSettings settings_;
+  std::unique_ptr<TransportRouter> router_;
+  // Версия справочника, которой соответствует router_
+  uint64_t catalogue_version_;
+  transport_catalogue::RouteCache route_cache_;
+};
@@ -0,0 +1,469 @@
+#include "serialization.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace serialization {
+
+  namespace {
+
+    constexpr char MAGIC[4] = {'T', 'C', 'D', 'B'};
+
+    struct Header {
+      char magic[4];
+      uint32_t version;
+      uint64_t payload_size;
+      uint64_t checksum;
+    };
+
+    // FNV-1a по всему содержимому после заголовка
+    uint64_t ComputeChecksum(const char *data, size_t size) {
+      uint64_t hash = 14695981039346656037ull;
+      for (size_t index = 0; index < size; ++index) {
+        hash ^= static_cast<unsigned char>(data[index]);
+        hash *= 1099511628211ull;
+      }
+      return hash;
+    }
+
+    class Writer {
+    public:
+      template<typename Type>
+      void Write(const Type &value) {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        buffer_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+      }
+
+      void WriteString(std::string_view value) {
+        Write<uint64_t>(value.size());
+        buffer_.append(value.data(), value.size());
+      }
+
+      // Массив пишется одним блоком вслед за длиной
+      template<typename Type>
+      void WriteVector(const std::vector<Type> &values) {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        Write<uint64_t>(values.size());
+        buffer_.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(Type));
+      }
+
+      const std::string &GetBuffer() const {
+        return buffer_;
+      }
+
+    private:
+      std::string buffer_;
+    };
+
+    class Reader {
+    public:
+      Reader(const char *begin, const char *end) : position_(begin), end_(end) {}
+
+      template<typename Type>
+      Type Read() {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        Require(sizeof(Type));
+        Type value;
+        std::memcpy(&value, position_, sizeof(Type));
+        position_ += sizeof(Type);
+        return value;
+      }
+
+      std::string ReadString() {
+        const auto size = Read<uint64_t>();
+        Require(size);
+        std::string result(position_, size);
+        position_ += size;
+        return result;
+      }
+
+      // Массив копируется из отображённого файла одним блоком
+      template<typename Type>
+      std::vector<Type> ReadVector() {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        const auto size = Read<uint64_t>();
+        if (size > static_cast<uint64_t>(end_ - position_) / sizeof(Type)) {
+          throw std::runtime_error("Unexpected end of base file");
+        }
+        std::vector<Type> result(size);
+        std::memcpy(result.data(), position_, size * sizeof(Type));
+        position_ += size * sizeof(Type);
+        return result;
+      }
+
+      bool IsAtEnd() const {
+        return position_ == end_;
+      }
+
+    private:
+      void Require(uint64_t size) const {
+        if (size > static_cast<uint64_t>(end_ - position_)) {
+          throw std::runtime_error("Unexpected end of base file");
+        }
+      }
+
+      const char *position_;
+      const char *end_;
+    };
+
+    // Файл, отображённый в память только для чтения
+    class MappedFile {
+    public:
+      explicit MappedFile(const std::string &path) {
+        const int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+          throw std::runtime_error("Cannot open base file " + path);
+        }
+        struct stat file_stat{};
+        if (fstat(descriptor, &file_stat) != 0) {
+          close(descriptor);
+          throw std::runtime_error("Cannot read base file " + path);
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (size_ != 0) {
+          void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+          if (data == MAP_FAILED) {
+            close(descriptor);
+            throw std::runtime_error("Cannot map base file " + path);
+          }
+          data_ = static_cast<const char *>(data);
+        }
+        close(descriptor);
+      }
+
+      MappedFile(const MappedFile &) = delete;
+
+      MappedFile &operator=(const MappedFile &) = delete;
+
+      ~MappedFile() {
+        if (data_) {
+          munmap(const_cast<char *>(data_), size_);
+        }
+      }
+
+      const char *GetData() const {
+        return data_;
+      }
+
+      size_t GetSize() const {
+        return size_;
+      }
+
+    private:
+      const char *data_ = nullptr;
+      size_t size_ = 0;
+    };
+
+    void WriteColor(Writer &writer, const svg::Color &color) {
+      writer.Write<uint8_t>(static_cast<uint8_t>(color.index()));
+      if (const auto *name = std::get_if<std::string>(&color)) {
+        writer.WriteString(*name);
+      } else if (const auto *rgb = std::get_if<svg::Rgb>(&color)) {
+        writer.Write(rgb->red);
+        writer.Write(rgb->green);
+        writer.Write(rgb->blue);
+      } else if (const auto *rgba = std::get_if<svg::Rgba>(&color)) {
+        writer.Write(rgba->red);
+        writer.Write(rgba->green);
+        writer.Write(rgba->blue);
+        writer.Write(rgba->opacity);
+      }
+    }
+
+    svg::Color ReadColor(Reader &reader) {
+      switch (reader.Read<uint8_t>()) {
+        case 0:
+          return std::monostate{};
+        case 1:
+          return reader.ReadString();
+        case 2: {
+          const auto red = reader.Read<uint8_t>();
+          const auto green = reader.Read<uint8_t>();
+          const auto blue = reader.Read<uint8_t>();
+          return svg::Rgb{red, green, blue};
+        }
+        case 3: {
+          const auto red = reader.Read<uint8_t>();
+          const auto green = reader.Read<uint8_t>();
+          const auto blue = reader.Read<uint8_t>();
+          const auto opacity = reader.Read<double>();
+          return svg::Rgba{red, green, blue, opacity};
+        }
+        default:
+          throw std::runtime_error("Unknown color type in base file");
+      }
+    }
+
+    void WriteRenderSettings(Writer &writer, const transport_catalogue::SvgInfo &settings) {
+      writer.Write(settings.width);
+      writer.Write(settings.height);
+      writer.Write(settings.padding);
+      writer.Write(settings.line_width);
+      writer.Write(settings.stop_radius);
+      writer.Write(settings.bus_label_font_size);
+      writer.Write(settings.bus_label_offset);
+      writer.Write(settings.stop_label_font_size);
+      writer.Write(settings.stop_label_offset);
+      WriteColor(writer, settings.underlayer_color);
+      writer.Write(settings.underlayer_width);
+      writer.Write<uint64_t>(settings.color_palette.size());
+      for (const auto &color: settings.color_palette) {
+        WriteColor(writer, color);
+      }
+    }
+
+    transport_catalogue::SvgInfo ReadRenderSettings(Reader &reader) {
+      transport_catalogue::SvgInfo settings;
+      settings.width = reader.Read<double>();
+      settings.height = reader.Read<double>();
+      settings.padding = reader.Read<double>();
+      settings.line_width = reader.Read<double>();
+      settings.stop_radius = reader.Read<double>();
+      settings.bus_label_font_size = reader.Read<int>();
+      settings.bus_label_offset = reader.Read<transport_catalogue::Offset>();
+      settings.stop_label_font_size = reader.Read<int>();
+      settings.stop_label_offset = reader.Read<transport_catalogue::Offset>();
+      settings.underlayer_color = ReadColor(reader);
+      settings.underlayer_width = reader.Read<double>();
+      const auto colors_count = reader.Read<uint64_t>();
+      for (uint64_t index = 0; index < colors_count; ++index) {
+        settings.color_palette.push_back(ReadColor(reader));
+      }
+      return settings;
+    }
+
+    void WriteRoutingSettings(Writer &writer, const RoutingSettings &settings) {
+      writer.Write(settings.bus_wait_time);
+      writer.Write(settings.bus_velocity);
+      writer.Write<uint32_t>(static_cast<uint32_t>(settings.algorithm));
+      writer.Write<uint64_t>(settings.build_threads);
+      writer.Write<uint64_t>(settings.matrix_threads);
+      writer.Write<uint32_t>(static_cast<uint32_t>(settings.all_pairs_precision));
+    }
+
+    RoutingSettings ReadRoutingSettings(Reader &reader) {
+      RoutingSettings settings;
+      settings.bus_wait_time = reader.Read<double>();
+      settings.bus_velocity = reader.Read<double>();
+      const auto algorithm = reader.Read<uint32_t>();
+      if (algorithm > static_cast<uint32_t>(RoutingAlgorithm::RAPTOR)) {
+        throw std::runtime_error("Unknown routing algorithm in base file");
+      }
+      settings.algorithm = static_cast<RoutingAlgorithm>(algorithm);
+      settings.build_threads = reader.Read<uint64_t>();
+      settings.matrix_threads = reader.Read<uint64_t>();
+      const auto precision = reader.Read<uint32_t>();
+      if (precision > static_cast<uint32_t>(AllPairsPrecision::FLOAT)) {
+        throw std::runtime_error("Unknown all pairs precision in base file");
+      }
+      settings.all_pairs_precision = static_cast<AllPairsPrecision>(precision);
+      return settings;
+    }
+
+    // Остановки пишутся в порядке идентификаторов, поэтому при чтении идентификаторы совпадут
+    void WriteCatalogue(Writer &writer, const transport_catalogue::TransportCatalogue &catalogue) {
+      writer.Write<uint64_t>(catalogue.GetStopsCount());
+      for (size_t stop_id = 0; stop_id < catalogue.GetStopsCount(); ++stop_id) {
+        writer.WriteString(catalogue.GetStopFromId(stop_id));
+        writer.Write(catalogue.GetStopCoordinates(stop_id));
+      }
+      const auto distances = catalogue.GetDistances();
+      writer.Write<uint64_t>(distances.size());
+      for (const auto &distance: distances) {
+        writer.Write<uint64_t>(distance.from);
+        writer.Write<uint64_t>(distance.to);
+        writer.Write(distance.distance);
+      }
+      const auto &buses = catalogue.GetBusesDequeConst();
+      writer.Write<uint64_t>(buses.size());
+      for (const auto &bus: buses) {
+        writer.WriteString(bus.name);
+        writer.Write(bus.is_roundtrip);
+        std::vector<uint64_t> stop_ids;
+        stop_ids.reserve(bus.stops.size());
+        for (const auto *stop: bus.stops) {
+          stop_ids.push_back(stop->id);
+        }
+        writer.WriteVector(stop_ids);
+      }
+    }
+
+    void ReadCatalogue(Reader &reader, transport_catalogue::TransportCatalogue &catalogue) {
+      using transport_catalogue::Stop;
+
+      std::vector<Stop *> stops(reader.Read<uint64_t>());
+      for (auto &stop: stops) {
+        auto name = reader.ReadString();
+        const auto coordinates = reader.Read<geo::Coordinates>();
+        catalogue.AddStop({name, coordinates});
+        stop = catalogue.FindStop(name);
+      }
+      auto get_stop = [&stops](uint64_t stop_id) {
+        if (stop_id >= stops.size()) {
+          throw std::runtime_error("Stop id is out of range in base file");
+        }
+        return stops[stop_id];
+      };
+
+      const auto distances_count = reader.Read<uint64_t>();
+      for (uint64_t index = 0; index < distances_count; ++index) {
+        Stop *from = get_stop(reader.Read<uint64_t>());
+        Stop *to = get_stop(reader.Read<uint64_t>());
+        catalogue.SetDistance(reader.Read<int64_t>(), from, to);
+      }
+
+      const auto buses_count = reader.Read<uint64_t>();
+      for (uint64_t index = 0; index < buses_count; ++index) {
+        auto name = reader.ReadString();
+        const bool is_roundtrip = reader.Read<bool>();
+        std::vector<Stop *> bus_stops;
+        for (const uint64_t stop_id: reader.ReadVector<uint64_t>()) {
+          bus_stops.push_back(get_stop(stop_id));
+        }
+        catalogue.AddBus({std::move(name), bus_stops, is_roundtrip});
+      }
+    }
+
+    template<typename Type>
+    void WriteOptional(Writer &writer, const std::optional<Type> &value, void (*write)(Writer &, const Type &)) {
+      writer.Write(value.has_value());
+      if (value) {
+        write(writer, *value);
+      }
+    }
+
+    template<typename AllPairsData>
+    void WriteAllPairsData(Writer &writer, const AllPairsData &data) {
+      writer.WriteVector(data.weights);
+      writer.WriteVector(data.prev_edges);
+    }
+
+    template<typename AllPairsData>
+    std::optional<AllPairsData> ReadAllPairsData(Reader &reader) {
+      if (!reader.Read<bool>()) {
+        return std::nullopt;
+      }
+      AllPairsData data;
+      data.weights = reader.ReadVector<typename decltype(data.weights)::value_type>();
+      data.prev_edges = reader.ReadVector<graph::PrevEdgeId>();
+      return data;
+    }
+
+    void WriteContractionHierarchyData(Writer &writer, const graph::ContractionHierarchy<double>::Data &data) {
+      writer.WriteVector(data.shortcuts);
+      writer.WriteVector(data.ranks);
+      writer.WriteVector(data.upward_offsets);
+      writer.WriteVector(data.upward_arcs);
+      writer.WriteVector(data.downward_offsets);
+      writer.WriteVector(data.downward_arcs);
+    }
+
+    void WriteRouterData(Writer &writer, const TransportRouter::Data &data) {
+      writer.WriteVector(data.graph.offsets);
+      writer.WriteVector(data.graph.targets);
+      writer.WriteVector(data.graph.weights);
+      writer.WriteVector(data.graph.payloads);
+      WriteOptional(writer, data.all_pairs, WriteAllPairsData);
+      WriteOptional(writer, data.compact_all_pairs, WriteAllPairsData);
+      WriteOptional(writer, data.contraction_hierarchy, WriteContractionHierarchyData);
+    }
+
+    TransportRouter::Data ReadRouterData(Reader &reader) {
+      using ContractionHierarchy = graph::ContractionHierarchy<double>;
+
+      TransportRouter::Data data;
+      data.graph.offsets = reader.ReadVector<graph::EdgeId>();
+      data.graph.targets = reader.ReadVector<graph::VertexId>();
+      data.graph.weights = reader.ReadVector<double>();
+      data.graph.payloads = reader.ReadVector<graph::DirectedWeightedGraph<double>::EdgePayload>();
+      data.all_pairs = ReadAllPairsData<graph::AllPairsRouter<double>::Data>(reader);
+      data.compact_all_pairs = ReadAllPairsData<graph::AllPairsRouter<double, float>::Data>(reader);
+      if (reader.Read<bool>()) {
+        ContractionHierarchy::Data hierarchy;
+        hierarchy.shortcuts = reader.ReadVector<ContractionHierarchy::Shortcut>();
+        hierarchy.ranks = reader.ReadVector<size_t>();
+        hierarchy.upward_offsets = reader.ReadVector<size_t>();
+        hierarchy.upward_arcs = reader.ReadVector<ContractionHierarchy::SearchArc>();
+        hierarchy.downward_offsets = reader.ReadVector<size_t>();
+        hierarchy.downward_arcs = reader.ReadVector<ContractionHierarchy::SearchArc>();
+        data.contraction_hierarchy = std::move(hierarchy);
+      }
+      return data;
+    }
+
+  } // namespace
+
+  void SaveBase(const std::string &path, const transport_catalogue::TransportCatalogue &catalogue,
+                const transport_catalogue::SvgInfo &render_settings, const TransportRouter &router) {
+    Writer writer;
+    WriteCatalogue(writer, catalogue);
+    WriteRenderSettings(writer, render_settings);
+    WriteRoutingSettings(writer, router.GetSettings());
+    WriteRouterData(writer, router.GetData());
+    const std::string &payload = writer.GetBuffer();
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.payload_size = payload.size();
+    header.checksum = ComputeChecksum(payload.data(), payload.size());
+
+    // Файл пишется под временным именем и подменяется целиком, чтобы читатель
+    // никогда не увидел недописанную базу
+    const std::string temporary_path = path + ".tmp";
+    {
+      std::ofstream output(temporary_path, std::ios::binary | std::ios::trunc);
+      output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      output.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+      if (!output) {
+        throw std::runtime_error("Cannot write base file " + temporary_path);
+      }
+    }
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+      throw std::runtime_error("Cannot write base file " + path);
+    }
+  }
+
+  Base LoadBase(const std::string &path, transport_catalogue::TransportCatalogue &catalogue) {
+    const MappedFile file(path);
+    Header header{};
+    if (file.GetSize() < sizeof(header)) {
+      throw std::runtime_error("Base file is too short");
+    }
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+      throw std::runtime_error("Not a transport catalogue base file");
+    }
+    if (header.version != FORMAT_VERSION) {
+      throw std::runtime_error("Unsupported base file version " + std::to_string(header.version));
+    }
+    const char *payload = file.GetData() + sizeof(header);
+    if (header.payload_size != file.GetSize() - sizeof(header)
+        || header.checksum != ComputeChecksum(payload, header.payload_size)) {
+      throw std::runtime_error("Base file is corrupted");
+    }
+
+    Reader reader(payload, payload + header.payload_size);
+    ReadCatalogue(reader, catalogue);
+    Base result;
+    result.render_settings = ReadRenderSettings(reader);
+    result.routing_settings = ReadRoutingSettings(reader);
+    result.router_data = ReadRouterData(reader);
+    if (!reader.IsAtEnd()) {
+      throw std::runtime_error("Base file is corrupted");
+    }
+    return result;
+  }
+
+}
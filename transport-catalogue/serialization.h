@@ -0,0 +1,31 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "map_renderer.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <string>
+
+namespace serialization {
+
+  // Версия формата файла базы, увеличивается при любом изменении раскладки данных
+  inline constexpr uint32_t FORMAT_VERSION = 2;
+
+  struct Base {
+    transport_catalogue::SvgInfo render_settings;
+    RoutingSettings routing_settings;
+    TransportRouter::Data router_data;
+  };
+
+  // Сохраняет справочник, настройки и построенные данные роутера в двоичный файл.
+  // Массивы пишутся в машинном представлении, поэтому файл переносим только между
+  // сборками для одной архитектуры.
+  void SaveBase(const std::string &path, const transport_catalogue::TransportCatalogue &catalogue,
+                const transport_catalogue::SvgInfo &render_settings, const TransportRouter &router);
+
+  // Отображает файл в память, проверяет версию и контрольную сумму и заполняет пустой справочник.
+  // Для повреждённого или несовместимого файла бросает std::runtime_error.
+  Base LoadBase(const std::string &path, transport_catalogue::TransportCatalogue &catalogue);
+
+}
@@ -0,0 +1,158 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace geo {
+
+  namespace {
+    // Запас на погрешность при переводе расстояния в хорду: точную проверку делает ComputeDistance
+    constexpr double CHORD_TOLERANCE = 1e-9;
+
+    double SquareDistance(const double (&lhs)[3], const double (&rhs)[3]) {
+      const double dx = lhs[0] - rhs[0];
+      const double dy = lhs[1] - rhs[1];
+      const double dz = lhs[2] - rhs[2];
+      return dx * dx + dy * dy + dz * dz;
+    }
+  }
+
+  SpatialIndex::SpatialIndex(const std::vector<Coordinates> &points) : points_(points) {
+    if (points.size() >= std::numeric_limits<uint32_t>::max()) {
+      throw std::length_error("Too many points for 32-bit ids");
+    }
+    nodes_.reserve(points.size());
+    for (size_t point_id = 0; point_id < points.size(); ++point_id) {
+      nodes_.push_back(MakeNode(points[point_id], static_cast<uint32_t>(point_id)));
+    }
+    Build(0, nodes_.size(), 0);
+  }
+
+  std::vector<std::pair<size_t, double>> SpatialIndex::FindNearest(Coordinates point, size_t count) const {
+    count = std::min(count, nodes_.size());
+    if (count == 0) {
+      return {};
+    }
+    Candidates candidates;
+    candidates.reserve(count + 1);
+    SearchNearest(MakeNode(point, 0), count, 0, nodes_.size(), 0, candidates);
+    std::vector<uint32_t> point_ids;
+    point_ids.reserve(candidates.size());
+    for (const auto &[chord_square, point_id]: candidates) {
+      point_ids.push_back(point_id);
+    }
+    return MakeResult(point, point_ids, std::numeric_limits<double>::infinity());
+  }
+
+  std::vector<std::pair<size_t, double>> SpatialIndex::FindInRadius(Coordinates point, double radius) const {
+    if (radius < 0 || nodes_.empty()) {
+      return {};
+    }
+    // Хорда для дуги длины radius, дальше полуокружности она не растёт
+    const double angle = std::min(radius / EARTH_RADIUS, M_PI);
+    const double max_chord = 2 * std::sin(angle / 2) * (1 + CHORD_TOLERANCE) + CHORD_TOLERANCE;
+    std::vector<uint32_t> point_ids;
+    SearchInRadius(MakeNode(point, 0), max_chord * max_chord, 0, nodes_.size(), 0, point_ids);
+    return MakeResult(point, point_ids, radius);
+  }
+
+  SpatialIndex::Node SpatialIndex::MakeNode(Coordinates point, uint32_t point_id) {
+    static const double dr = M_PI / 180.;
+    const double lat = point.lat * dr;
+    const double lng = point.lng * dr;
+    return {{std::cos(lat) * std::cos(lng), std::cos(lat) * std::sin(lng), std::sin(lat)}, point_id};
+  }
+
+  void SpatialIndex::Build(size_t begin, size_t end, size_t depth) {
+    if (end - begin <= 1) {
+      return;
+    }
+    const size_t axis = depth % 3;
+    const size_t middle = begin + (end - begin) / 2;
+    std::nth_element(nodes_.begin() + begin, nodes_.begin() + middle, nodes_.begin() + end,
+                     [axis](const Node &lhs, const Node &rhs) {
+                       return lhs.position[axis] < rhs.position[axis];
+                     });
+    Build(begin, middle, depth + 1);
+    Build(middle + 1, end, depth + 1);
+  }
+
+  void SpatialIndex::SearchNearest(const Node &target, size_t count, size_t begin, size_t end, size_t depth,
+                                   Candidates &candidates) const {
+    if (begin >= end) {
+      return;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    const Node &node = nodes_[middle];
+    const std::pair candidate{SquareDistance(node.position, target.position), node.point_id};
+    if (candidates.size() < count) {
+      candidates.push_back(candidate);
+      std::push_heap(candidates.begin(), candidates.end());
+    } else if (candidate < candidates.front()) {
+      std::pop_heap(candidates.begin(), candidates.end());
+      candidates.back() = candidate;
+      std::push_heap(candidates.begin(), candidates.end());
+    }
+
+    const size_t axis = depth % 3;
+    const double offset = target.position[axis] - node.position[axis];
+    const bool is_left_first = offset < 0;
+    const size_t near_begin = is_left_first ? begin : middle + 1;
+    const size_t near_end = is_left_first ? middle : end;
+    SearchNearest(target, count, near_begin, near_end, depth + 1, candidates);
+    // Дальнее поддерево не ближе плоскости разбиения. Равные расстояния не отсекаются,
+    // чтобы при равенстве выбирались точки с меньшими номерами.
+    if (candidates.size() < count || offset * offset <= candidates.front().first) {
+      const size_t far_begin = is_left_first ? middle + 1 : begin;
+      const size_t far_end = is_left_first ? end : middle;
+      SearchNearest(target, count, far_begin, far_end, depth + 1, candidates);
+    }
+  }
+
+  void SpatialIndex::SearchInRadius(const Node &target, double max_chord_square, size_t begin, size_t end,
+                                    size_t depth, std::vector<uint32_t> &result) const {
+    if (begin >= end) {
+      return;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    const Node &node = nodes_[middle];
+    if (SquareDistance(node.position, target.position) <= max_chord_square) {
+      result.push_back(node.point_id);
+    }
+    const double offset = target.position[depth % 3] - node.position[depth % 3];
+    if (offset <= 0 || offset * offset <= max_chord_square) {
+      SearchInRadius(target, max_chord_square, begin, middle, depth + 1, result);
+    }
+    if (offset >= 0 || offset * offset <= max_chord_square) {
+      SearchInRadius(target, max_chord_square, middle + 1, end, depth + 1, result);
+    }
+  }
+
+  std::vector<std::pair<size_t, double>> SpatialIndex::MakeResult(Coordinates point,
+                                                                  const std::vector<uint32_t> &point_ids,
+                                                                  double max_distance) const {
+    std::vector<std::pair<double, size_t>> found;
+    found.reserve(point_ids.size());
+    for (const uint32_t point_id: point_ids) {
+      double distance = ComputeDistance(point, points_[point_id]);
+      // Для почти совпадающих точек аргумент acos из-за округления выходит за 1
+      if (std::isnan(distance)) {
+        distance = 0;
+      }
+      if (distance <= max_distance) {
+        found.emplace_back(distance, point_id);
+      }
+    }
+    std::sort(found.begin(), found.end());
+    std::vector<std::pair<size_t, double>> result;
+    result.reserve(found.size());
+    for (const auto &[distance, point_id]: found) {
+      result.emplace_back(point_id, distance);
+    }
+    return result;
+  }
+
+}  // namespace geo
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace geo {
+
+  // k-d дерево по точкам на сфере. Координаты переводятся в единичные векторы, длина хорды
+  // между которыми монотонно растёт с расстоянием по поверхности, поэтому отсечение
+  // ветвей не зависит от долготы и работает через 180-й меридиан и у полюсов.
+  // Итоговые расстояния считаются через ComputeDistance.
+  class SpatialIndex {
+  public:
+    // Номер точки в результатах совпадает с её позицией в points
+    explicit SpatialIndex(const std::vector<Coordinates> &points);
+
+    // Не более count ближайших точек с расстояниями в метрах, по возрастанию расстояния,
+    // при равенстве - по номеру
+    std::vector<std::pair<size_t, double>> FindNearest(Coordinates point, size_t count) const;
+
+    // Все точки не дальше radius метров в том же порядке
+    std::vector<std::pair<size_t, double>> FindInRadius(Coordinates point, double radius) const;
+
+    size_t GetPointsCount() const {
+      return nodes_.size();
+    }
+
+  private:
+    struct Node {
+      double position[3];
+      uint32_t point_id;
+    };
+
+    // Максимальная куча ближайших найденных точек по (квадрат хорды, номер)
+    using Candidates = std::vector<std::pair<double, uint32_t>>;
+
+    static Node MakeNode(Coordinates point, uint32_t point_id);
+
+    // Узлы [begin, end) - поддерево, его корень - средний узел, делящий по оси depth % 3
+    void Build(size_t begin, size_t end, size_t depth);
+
+    void SearchNearest(const Node &target, size_t count, size_t begin, size_t end, size_t depth,
+                       Candidates &candidates) const;
+
+    void SearchInRadius(const Node &target, double max_chord_square, size_t begin, size_t end, size_t depth,
+                        std::vector<uint32_t> &result) const;
+
+    // Точные расстояния до найденных точек и их упорядочивание
+    std::vector<std::pair<size_t, double>> MakeResult(Coordinates point, const std::vector<uint32_t> &point_ids,
+                                                      double max_distance) const;
+
+    std::vector<Node> nodes_;
+    std::vector<Coordinates> points_;
+  };
+
+}  // namespace geo
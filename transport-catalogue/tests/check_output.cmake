@@ -0,0 +1,22 @@
+# Запускает программу на входном файле и сравнивает вывод с эталоном побайтово.
+# Параметры: PROGRAM, INPUT, EXPECTED, OUTPUT; при SAVED_BASE сначала строится база
+# в режиме make_base, а запросы обрабатываются в режиме process_requests.
+if(SAVED_BASE)
+  execute_process(COMMAND ${PROGRAM} make_base INPUT_FILE ${INPUT} RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "make_base failed: ${result}")
+  endif()
+  execute_process(COMMAND ${PROGRAM} process_requests INPUT_FILE ${INPUT} OUTPUT_FILE ${OUTPUT}
+                  RESULT_VARIABLE result)
+else()
+  execute_process(COMMAND ${PROGRAM} INPUT_FILE ${INPUT} OUTPUT_FILE ${OUTPUT} RESULT_VARIABLE result)
+endif()
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${PROGRAM} failed: ${result}")
+endif()
+
+file(READ ${OUTPUT} actual)
+file(READ ${EXPECTED} expected)
+if(NOT actual STREQUAL expected)
+  message(FATAL_ERROR "Output ${OUTPUT} differs from ${EXPECTED}")
+endif()
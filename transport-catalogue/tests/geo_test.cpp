@@ -0,0 +1,110 @@
+// Пакетный расчёт расстояний сверяется со скалярным эталоном для каждого доступного ядра
+
+#define _USE_MATH_DEFINES
+#include "geo.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+  const double HALF_CIRCUMFERENCE = M_PI * geo::EARTH_RADIUS;
+
+  struct PointPairs {
+    std::vector<geo::Coordinates> from;
+    std::vector<geo::Coordinates> to;
+  };
+
+  // Пары на расстояниях от долей метра до полуокружности, совпадающие точки и точки через 180-й меридиан
+  PointPairs MakePointPairs() {
+    std::mt19937 generator(23);
+    std::uniform_real_distribution<double> latitude_distribution(-89., 89.);
+    std::uniform_real_distribution<double> longitude_distribution(-180., 180.);
+    std::uniform_real_distribution<double> exponent_distribution(-5., 2.);
+    PointPairs result;
+    for (size_t index = 0; index < 4003; ++index) {
+      const geo::Coordinates from{latitude_distribution(generator), longitude_distribution(generator)};
+      geo::Coordinates to = from;
+      switch (index % 5) {
+        case 0:
+          break;
+        case 1:
+          to = {latitude_distribution(generator), longitude_distribution(generator)};
+          break;
+        case 2:
+          to = {-from.lat, from.lng > 0 ? from.lng - 180 : from.lng + 180};
+          break;
+        default: {
+          // Смещение от 1e-5 до 100 градусов
+          const double offset = std::pow(10., exponent_distribution(generator));
+          to = {std::clamp(from.lat + offset * 0.6, -90., 90.), from.lng + offset * 0.8};
+          break;
+        }
+      }
+      result.from.push_back(from);
+      result.to.push_back(to);
+    }
+    return result;
+  }
+
+  void CheckKernel(geo::DistanceKernel kernel, const PointPairs &pairs) {
+    std::vector<geo::PreparedCoordinates> from;
+    std::vector<geo::PreparedCoordinates> to;
+    for (size_t index = 0; index < pairs.from.size(); ++index) {
+      from.push_back(geo::PrepareCoordinates(pairs.from[index]));
+      to.push_back(geo::PrepareCoordinates(pairs.to[index]));
+    }
+    // Разные длины пакета проверяют и четвёрки, и хвост
+    for (size_t count = 0; count <= from.size(); count += count < 16 ? 1 : 997) {
+      std::vector<double> distances(count);
+      geo::ComputeDistances(from.data(), to.data(), distances.data(), count, kernel);
+      for (size_t index = 0; index < count; ++index) {
+        const double distance = distances[index];
+        // С подготовленными координатами ядро совпадает с поштучным расчётом до бита
+        const double prepared_distance = geo::ComputeDistance(from[index], to[index]);
+        ASSERT(std::memcmp(&distance, &prepared_distance, sizeof(double)) == 0);
+
+        ASSERT(std::isfinite(distance) && distance >= 0);
+        const double reference = geo::ComputeDistance(pairs.from[index], pairs.to[index]);
+        if (std::isnan(reference)) {
+          // Эталон даёт NaN, когда для почти совпадающих или почти противоположных точек
+          // аргумент acos выходит за пределы [-1, 1]
+          ASSERT(distance < 1 || distance > HALF_CIRCUMFERENCE - 1);
+          continue;
+        }
+        // Обе формулы берут acos от косинуса около 1 или -1: ошибка округления порядка 1e-16
+        // в косинусе даёт абсолютную ошибку около 9e-3 / d метров, где d - расстояние
+        // до той же или до противоположной точки
+        const double conditioning = std::min(reference, HALF_CIRCUMFERENCE - reference);
+        ASSERT(std::abs(distance - reference) <= 1e-9 * reference + 2e-2 / std::max(conditioning, 1e-3));
+      }
+    }
+  }
+
+  void TestScalarKernel() {
+    CheckKernel(geo::DistanceKernel::SCALAR, MakePointPairs());
+  }
+
+  void TestAvx2Kernel() {
+    if (!geo::IsDistanceKernelSupported(geo::DistanceKernel::AVX2)) {
+      std::cerr << "AVX2 is not supported, the kernel is not checked" << std::endl;
+      return;
+    }
+    CheckKernel(geo::DistanceKernel::AVX2, MakePointPairs());
+  }
+
+  void TestAutoKernel() {
+    CheckKernel(geo::DistanceKernel::AUTO, MakePointPairs());
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestScalarKernel);
+  RUN_TEST(TestAvx2Kernel);
+  RUN_TEST(TestAutoKernel);
+}
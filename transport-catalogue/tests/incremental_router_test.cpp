@@ -0,0 +1,153 @@
+// Роутер после последовательности инкрементальных изменений отвечает так же,
+// как роутер, построенный заново по тому же состоянию справочника
+
+#include "test_utils.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace transport_catalogue;
+
+namespace {
+
+  void CheckSameRoutes(const TransportRouter &router, const TransportCatalogue &catalogue,
+                       const RoutingSettings &settings) {
+    const TransportRouter expected_router(catalogue, settings);
+    for (graph::VertexId from = 0; from < catalogue.GetStopsCount(); ++from) {
+      for (graph::VertexId to = 0; to < catalogue.GetStopsCount(); ++to) {
+        const auto expected = expected_router.BuildRoute(from, to);
+        const auto route = router.BuildRoute(from, to);
+        ASSERT_EQUAL(expected.has_value(), route.has_value());
+        if (route) {
+          ASSERT(tests::IsSameTime(expected->total_time, route->total_time));
+          tests::CheckRouteConsistency(*route, from, to);
+        }
+      }
+    }
+  }
+
+  // Новые расстояния сообщаются роутеру, как если бы их задали запросом
+  void SetRandomDistances(TransportCatalogue &catalogue, TransportRouter &router, std::mt19937 &generator,
+                          const std::vector<Stop *> &stops) {
+    tests::AddRandomDistances(catalogue, generator, stops);
+    for (size_t index = 0; index + 1 < stops.size(); ++index) {
+      router.UpdateDistance(stops[index]->id, stops[index + 1]->id);
+    }
+  }
+
+  void TestIncrementalUpdates(RoutingAlgorithm algorithm) {
+    std::mt19937 generator(static_cast<unsigned>(algorithm) + 1);
+    TransportCatalogue catalogue;
+    tests::FillRandomCatalogue(catalogue, generator, 40, 12);
+    RoutingSettings settings;
+    settings.bus_wait_time = 3;
+    settings.bus_velocity = 500;
+    settings.algorithm = algorithm;
+    TransportRouter router(catalogue, settings);
+    // Деревья поиска попадают в кэш до изменений, чтобы проверялось их исправление
+    CheckSameRoutes(router, catalogue, settings);
+
+    for (int step = 0; step < 24; ++step) {
+      const size_t buses_count = catalogue.GetBusesDequeConst().size();
+      Bus &bus = *catalogue.FindBus(catalogue.GetBusFromId(generator() % buses_count).name);
+      switch (step % 4) {
+        case 0:
+          if (bus.stops.size() >= 2) {
+            const size_t index = generator() % (bus.stops.size() - 1);
+            SetRandomDistances(catalogue, router, generator, {bus.stops[index], bus.stops[index + 1]});
+          }
+          break;
+        case 1:
+          // Маршрут меняет состав остановок, удалённый маршрут при этом возвращается
+          bus.stops = tests::MakeRandomStops(catalogue, generator, bus.is_roundtrip);
+          SetRandomDistances(catalogue, router, generator, bus.stops);
+          router.UpdateBus(bus.id);
+          break;
+        case 2: {
+          const bool is_roundtrip = generator() % 2 == 0;
+          auto stops = tests::MakeRandomStops(catalogue, generator, is_roundtrip);
+          catalogue.AddBus({"New bus " + std::to_string(step), stops, is_roundtrip});
+          SetRandomDistances(catalogue, router, generator, stops);
+          router.UpdateBus(buses_count);
+          break;
+        }
+        default:
+          router.RemoveBus(bus.id);
+          // Эталонный роутер строится по справочнику, в котором у маршрута нет остановок
+          bus.stops.clear();
+          break;
+      }
+      CheckSameRoutes(router, catalogue, settings);
+    }
+  }
+
+  void TestIncrementalUpdatesForAllAlgorithms() {
+    for (const RoutingAlgorithm algorithm: tests::GetAllAlgorithms()) {
+      TestIncrementalUpdates(algorithm);
+    }
+  }
+
+  // Правка CSR на месте даёт тот же граф, что и сборка с нуля, с точностью до порядка рёбер вершины
+  void TestReplaceEdgesMatchesBuilder() {
+    std::mt19937 generator(7);
+    const size_t vertex_count = 50;
+    std::uniform_int_distribution<graph::VertexId> vertex_distribution(0, vertex_count - 1);
+    std::vector<graph::Edge<double>> edges;
+    for (size_t index = 0; index < 400; ++index) {
+      edges.push_back({vertex_distribution(generator), vertex_distribution(generator),
+                       static_cast<double>(index), static_cast<uint32_t>(index), 1});
+    }
+    graph::GraphBuilder<double> builder(vertex_count);
+    for (const auto &edge: edges) {
+      builder.AddEdge(edge);
+    }
+    auto graph = builder.Build();
+
+    std::vector<graph::EdgeId> removed_edges;
+    std::vector<bool> is_removed(graph.GetEdgeCount(), false);
+    for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); edge_id += 3) {
+      removed_edges.push_back(edge_id);
+      is_removed[edge_id] = true;
+    }
+    std::vector<graph::Edge<double>> added_edges;
+    for (size_t index = 0; index < 100; ++index) {
+      added_edges.push_back({vertex_distribution(generator), vertex_distribution(generator),
+                             1000. + static_cast<double>(index), static_cast<uint32_t>(1000 + index), 2});
+    }
+    const auto old_graph = graph;
+    std::vector<graph::EdgeId> added_edge_ids;
+    const auto new_edge_ids = graph.ReplaceEdges(removed_edges, added_edges, &added_edge_ids);
+
+    ASSERT_EQUAL(graph.GetEdgeCount(), old_graph.GetEdgeCount() - removed_edges.size() + added_edges.size());
+    for (graph::EdgeId edge_id = 0; edge_id < old_graph.GetEdgeCount(); ++edge_id) {
+      if (is_removed[edge_id]) {
+        ASSERT_EQUAL(new_edge_ids[edge_id], graph::NO_EDGE);
+        continue;
+      }
+      const auto old_edge = old_graph.GetEdge(edge_id);
+      const auto new_edge = graph.GetEdge(new_edge_ids[edge_id]);
+      ASSERT_EQUAL(old_edge.from, new_edge.from);
+      ASSERT_EQUAL(old_edge.to, new_edge.to);
+      ASSERT_EQUAL(old_edge.bus_id, new_edge.bus_id);
+      // Оставшиеся рёбра сохраняют взаимный порядок
+      if (edge_id > 0 && !is_removed[edge_id - 1]) {
+        ASSERT(new_edge_ids[edge_id - 1] < new_edge_ids[edge_id]);
+      }
+    }
+    ASSERT_EQUAL(added_edge_ids.size(), added_edges.size());
+    for (size_t index = 0; index < added_edges.size(); ++index) {
+      const auto edge = graph.GetEdge(added_edge_ids[index]);
+      ASSERT_EQUAL(edge.from, added_edges[index].from);
+      ASSERT_EQUAL(edge.to, added_edges[index].to);
+      ASSERT_EQUAL(edge.bus_id, added_edges[index].bus_id);
+      ASSERT_EQUAL(edge.span_count, 2);
+    }
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestReplaceEdgesMatchesBuilder);
+  RUN_TEST(TestIncrementalUpdatesForAllAlgorithms);
+}
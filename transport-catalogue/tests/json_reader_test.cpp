@@ -0,0 +1,103 @@
+// Потоковая загрузка base_requests: поля в любом порядке, ссылки вперёд и отказ
+// от неполных запросов с теми же исключениями, что при разборе через дерево
+
+#include "json_reader.h"
+#include "test_utils.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace transport_catalogue;
+using namespace std::literals;
+
+namespace {
+
+  json::Dict LoadDocument(const std::string &text, TransportCatalogue &catalogue) {
+    std::istringstream input(text);
+    return LoadRequestsDocument(input, catalogue);
+  }
+
+  template<typename Exception>
+  bool Throws(const std::string &base_requests) {
+    TransportCatalogue catalogue;
+    try {
+      LoadDocument(R"({"base_requests": )" + base_requests + "}", catalogue);
+    } catch (const Exception &) {
+      return true;
+    }
+    return false;
+  }
+
+  void TestLoadsBaseRequests() {
+    TransportCatalogue catalogue;
+    // Маршрут и расстояние ссылаются на остановку, описанную позже, ключи идут в разном порядке
+    const auto other_sections = LoadDocument(R"({
+      "stat_requests": [{"id": 1, "type": "Bus", "name": "14"}],
+      "base_requests": [
+        {"is_roundtrip": false, "stops": ["A", "B"], "name": "14", "type": "Bus"},
+        {"road_distances": {"B": 1200}, "longitude": 37.6, "type": "Stop", "name": "A", "latitude": 55.6,
+         "unknown": {"nested": [1, 2, {"x": null}]}},
+        {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.61, "name": "Ignored"},
+        {"type": "Bus", "name": "ring", "stops": ["A", "B", "A"], "is_roundtrip": true}
+      ],
+      "render_settings": {}
+    })", catalogue);
+
+    ASSERT_EQUAL(other_sections.size(), 2u);
+    ASSERT(other_sections.count("stat_requests"));
+    ASSERT(other_sections.count("render_settings"));
+
+    ASSERT_EQUAL(catalogue.GetStopsCount(), 2u);
+    Stop *a = catalogue.FindStop("A");
+    Stop *b = catalogue.FindStop("B");
+    ASSERT(a && b);
+    ASSERT(catalogue.FindStop("Ignored") == nullptr);
+    ASSERT(a->coordinates == (geo::Coordinates{55.6, 37.6}));
+    ASSERT_EQUAL(catalogue.GetDistance(a, b), 1200);
+    ASSERT_EQUAL(catalogue.GetDistance(b, a), 1200);
+
+    const Bus *bus = catalogue.FindBus("14");
+    ASSERT(bus && !bus->is_roundtrip);
+    // Некольцевой маршрут хранится с обратным путём
+    ASSERT((bus->stops == std::vector<Stop *>{a, b, a}));
+    const Bus *ring = catalogue.FindBus("ring");
+    ASSERT(ring && ring->is_roundtrip);
+    ASSERT((ring->stops == std::vector<Stop *>{a, b, a}));
+    // Маршруты добавляются в порядке описания
+    ASSERT_EQUAL(catalogue.GetBusFromId(0).name, "14"s);
+  }
+
+  void TestAddStopReturnsStop() {
+    TransportCatalogue catalogue;
+    Stop *first = catalogue.AddStop({"First", {55.6, 37.6}});
+    Stop *second = catalogue.AddStop({"Second", {55.7, 37.7}});
+    ASSERT(first == catalogue.FindStop("First"));
+    ASSERT(second == catalogue.FindStop("Second"));
+    ASSERT_EQUAL(second->id, 1u);
+  }
+
+  void TestRejectsIncompleteRequests() {
+    ASSERT(Throws<std::out_of_range>(R"([{"name": "A", "latitude": 55.6, "longitude": 37.6}])"));
+    ASSERT(Throws<std::out_of_range>(R"([{"type": "Stop", "latitude": 55.6, "longitude": 37.6}])"));
+    ASSERT(Throws<std::out_of_range>(R"([{"type": "Stop", "name": "A", "longitude": 37.6}])"));
+    ASSERT(Throws<std::out_of_range>(R"([{"type": "Stop", "name": "A", "latitude": 55.6}])"));
+    ASSERT(Throws<std::out_of_range>(R"([{"type": "Bus", "stops": [], "is_roundtrip": true}])"));
+    ASSERT(Throws<std::out_of_range>(R"([{"type": "Bus", "name": "14", "is_roundtrip": true}])"));
+    ASSERT(Throws<std::out_of_range>(R"([{"type": "Bus", "name": "14", "stops": []}])"));
+    ASSERT(Throws<std::invalid_argument>(R"([{"type": "Tram", "name": "T", "stops": [], "is_roundtrip": true}])"));
+    // Ссылки на неизвестные остановки
+    ASSERT(Throws<std::invalid_argument>(R"([{"type": "Bus", "name": "14", "stops": ["X"], "is_roundtrip": true}])"));
+    ASSERT(Throws<std::invalid_argument>(
+        R"([{"type": "Stop", "name": "A", "latitude": 55.6, "longitude": 37.6, "road_distances": {"X": 10}}])"));
+    // Поле неверного типа
+    ASSERT(Throws<json::ParsingError>(R"([{"type": "Stop", "name": "A", "latitude": "55.6", "longitude": 37.6}])"));
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestLoadsBaseRequests);
+  RUN_TEST(TestAddStopReturnsStop);
+  RUN_TEST(TestRejectsIncompleteRequests);
+}
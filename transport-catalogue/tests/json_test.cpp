@@ -0,0 +1,107 @@
+// Разбор JSON: строки с особыми символами в любой позиции относительно восьмибайтовых слов,
+// которыми просматривается текст, печать с повторным разбором и ошибки разбора
+
+#include "json.h"
+#include "test_utils.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std::literals;
+
+namespace {
+
+  json::Node LoadText(const std::string &text) {
+    return json::Load(std::string_view(text)).GetRoot();
+  }
+
+  bool ThrowsParsingError(const std::string &text) {
+    try {
+      LoadText(text);
+    } catch (const json::ParsingError &) {
+      return true;
+    }
+    return false;
+  }
+
+  void TestStringsAroundWordBoundaries() {
+    const std::pair<std::string, std::string> escapes[] = {
+        {"\\\""s, "\""s}, {"\\\\"s, "\\"s}, {"\\n"s, "\n"s}, {"\\r"s, "\r"s}, {"\\t"s, "\t"s}};
+    for (size_t length = 0; length <= 24; ++length) {
+      std::string plain;
+      for (size_t i = 0; i < length; ++i) {
+        plain.push_back(static_cast<char>('a' + i % 26));
+      }
+      ASSERT_EQUAL(LoadText('"' + plain + '"').AsString(), plain);
+      // Строка без закрывающей кавычки обрывается в любом месте слова
+      ASSERT(ThrowsParsingError('"' + plain));
+      // Байты с установленным старшим битом не принимаются за особые символы
+      const std::string utf8 = plain + "\xD0\x90\xD0\xB1"s;
+      ASSERT_EQUAL(LoadText('"' + utf8 + '"').AsString(), utf8);
+
+      for (size_t position = 0; position <= length; ++position) {
+        const std::string prefix = plain.substr(0, position);
+        const std::string suffix = plain.substr(position);
+        for (const auto &[escaped, unescaped]: escapes) {
+          ASSERT_EQUAL(LoadText('"' + prefix + escaped + suffix + '"').AsString(), prefix + unescaped + suffix);
+        }
+        ASSERT(ThrowsParsingError('"' + prefix + '\n' + suffix + '"'));
+        ASSERT(ThrowsParsingError('"' + prefix + '\r' + suffix + '"'));
+        ASSERT(ThrowsParsingError('"' + prefix + "\\x"s + suffix + '"'));
+      }
+    }
+  }
+
+  void TestPrintAndLoadAgain() {
+    const json::Node root = LoadText(R"({
+      "array": [1, -2, 3.5, -0.25, 1.25e1, 2E-2, true, false, null, "", []],
+      "nested": {"inner": {"key": "value with \"quotes\", \\slashes\\ and\nnew lines\r"}},
+      "empty": {},
+      "long string without special characters": "0123456789abcdefghijklmnopqrstuvwxyz"
+    })");
+    const auto &dict = root.AsMap();
+    ASSERT_EQUAL(dict.size(), 4u);
+    const auto &array = dict.at("array"s).AsArray();
+    ASSERT_EQUAL(array.size(), 11u);
+    ASSERT(array[0].IsInt() && array[0].AsInt() == 1);
+    ASSERT(array[1].IsInt() && array[1].AsInt() == -2);
+    ASSERT(array[2].IsPureDouble() && array[2].AsDouble() == 3.5);
+    ASSERT_EQUAL(array[3].AsDouble(), -0.25);
+    ASSERT(array[4].IsPureDouble() && array[4].AsDouble() == 12.5);
+    ASSERT_EQUAL(array[5].AsDouble(), 2e-2);
+    ASSERT(array[6].AsBool() && !array[7].AsBool() && array[8].IsNull());
+    ASSERT(array[9].AsString().empty() && array[10].AsArray().empty());
+    ASSERT_EQUAL(dict.at("nested"s).AsMap().at("inner"s).AsMap().at("key"s).AsString(),
+                 "value with \"quotes\", \\slashes\\ and\nnew lines\r"s);
+
+    // Целое значение в экспоненциальной записи остаётся вещественным, но печатается без дробной части,
+    // поэтому в документ для повторного разбора не входит
+    ASSERT(LoadText("1e3"s).IsPureDouble());
+
+    std::ostringstream output;
+    json::Print(json::Document(root), output);
+    ASSERT(LoadText(output.str()) == root);
+  }
+
+  void TestParsingErrors() {
+    ASSERT(ThrowsParsingError("[1, 2"s));
+    ASSERT(ThrowsParsingError("{\"a\": 1"s));
+    ASSERT(ThrowsParsingError("{\"a\" 1}"s));
+    ASSERT(ThrowsParsingError("]"s));
+    ASSERT(ThrowsParsingError("}"s));
+    ASSERT(ThrowsParsingError("nul"s));
+    ASSERT(ThrowsParsingError("tru"s));
+    ASSERT(ThrowsParsingError("fals"s));
+    ASSERT(ThrowsParsingError("-"s));
+    ASSERT(ThrowsParsingError("1."s));
+    ASSERT(ThrowsParsingError("1e"s));
+    ASSERT(ThrowsParsingError("\"abc\\"s));
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestStringsAroundWordBoundaries);
+  RUN_TEST(TestPrintAndLoadAgain);
+  RUN_TEST(TestParsingErrors);
+}
@@ -0,0 +1,99 @@
+// Маршруты, оптимальные по Парето по времени и числу поездок: поиск по графу и RAPTOR
+// дают один и тот же фронт, совпадающий с перебором по раундам поездок из справочника
+
+#include "test_utils.h"
+
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace transport_catalogue;
+
+namespace {
+
+  // Фронт для пары остановок: (число поездок, время), число поездок растёт, время убывает
+  using Front = std::vector<std::pair<size_t, double>>;
+
+  // Раунд k - лучшее время до каждой остановки не более чем за k поездок
+  std::vector<Front> ComputeReferenceFronts(size_t stops_count, graph::VertexId from, const tests::Rides &rides) {
+    constexpr double INF = std::numeric_limits<double>::infinity();
+    std::vector<double> times(stops_count, INF);
+    times[from] = 0;
+    std::vector<Front> fronts(stops_count);
+    fronts[from].emplace_back(0, 0.);
+    for (size_t legs = 1; legs < stops_count; ++legs) {
+      std::vector<double> next_times = times;
+      for (const auto &[ride, time]: rides) {
+        const double candidate = times[std::get<0>(ride)] + time;
+        double &current = next_times[std::get<1>(ride)];
+        current = std::min(current, candidate);
+      }
+      for (graph::VertexId to = 0; to < stops_count; ++to) {
+        if (next_times[to] < times[to]) {
+          fronts[to].emplace_back(legs, next_times[to]);
+        }
+      }
+      times = std::move(next_times);
+    }
+    return fronts;
+  }
+
+  void CheckFront(const std::vector<TransportRouter::Route> &routes, const Front &expected,
+                  graph::VertexId from, graph::VertexId to, const tests::Rides &rides) {
+    ASSERT_EQUAL(routes.size(), expected.size());
+    for (size_t index = 0; index < routes.size(); ++index) {
+      ASSERT_EQUAL(routes[index].legs.size(), expected[index].first);
+      ASSERT_EQUAL(routes[index].total_time, expected[index].second);
+      tests::CheckRouteConsistency(routes[index], from, to);
+      tests::CheckRouteRides(routes[index], rides);
+    }
+  }
+
+  void TestParetoFronts() {
+    std::mt19937 generator(77);
+    for (const size_t buses_count: {6, 15, 30}) {
+      TransportCatalogue catalogue;
+      tests::FillRandomCatalogue(catalogue, generator, 35, buses_count);
+      RoutingSettings settings;
+      // Скорость - степень двойки, поэтому время поездок и их сумм вычисляется точно,
+      // и равные по времени маршруты не различаются из-за порядка сложения
+      settings.bus_wait_time = static_cast<double>(generator() % 7);
+      settings.bus_velocity = 256.;
+      const auto rides = tests::CollectRides(catalogue, settings);
+      const size_t stops_count = catalogue.GetStopsCount();
+
+      settings.algorithm = RoutingAlgorithm::DIJKSTRA;
+      const TransportRouter graph_router(catalogue, settings);
+      settings.algorithm = RoutingAlgorithm::RAPTOR;
+      const TransportRouter raptor_router(catalogue, settings);
+
+      for (graph::VertexId from = 0; from < stops_count; ++from) {
+        const auto fronts = ComputeReferenceFronts(stops_count, from, rides);
+        for (graph::VertexId to = 0; to < stops_count; ++to) {
+          if (from == to) {
+            continue;
+          }
+          CheckFront(graph_router.BuildParetoRoutes(from, to), fronts[to], from, to, rides);
+          CheckFront(raptor_router.BuildParetoRoutes(from, to), fronts[to], from, to, rides);
+          // Ограничение на пересадки отрезает фронт по числу поездок
+          for (const size_t max_transfers: {0, 1, 2}) {
+            Front limited;
+            for (const auto &entry: fronts[to]) {
+              if (entry.first <= max_transfers + 1) {
+                limited.push_back(entry);
+              }
+            }
+            CheckFront(graph_router.BuildParetoRoutes(from, to, max_transfers), limited, from, to, rides);
+            CheckFront(raptor_router.BuildParetoRoutes(from, to, max_transfers), limited, from, to, rides);
+          }
+        }
+      }
+    }
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestParetoFronts);
+}
@@ -0,0 +1,102 @@
+// Кэш ответов Route: повторные пары остановок отвечаются из кэша, счётчики попаданий
+// и промахов видны через RoutingService, а изменение справочника очищает кэш
+
+#include "json_reader.h"
+#include "test_utils.h"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace transport_catalogue;
+
+namespace {
+
+  SvgInfo MakeRenderSettings() {
+    return {600., 400., 50., 14., 5., 20, {7., 15.}, 18, {7., -3.}, svg::Color{"white"}, 3.,
+            {svg::Color{"green"}, svg::Color{"red"}}};
+  }
+
+  // Пары повторяются: на 12 запросов 4 разные пары, включая недостижимую
+  json::Array MakeRouteRequests(const std::vector<std::pair<size_t, size_t>> &pairs, size_t repeats) {
+    json::Array requests;
+    int request_id = 1;
+    for (size_t repeat = 0; repeat < repeats; ++repeat) {
+      for (const auto &[from, to]: pairs) {
+        requests.emplace_back(json::Dict{{"id", request_id++}, {"type", "Route"},
+                                         {"from", tests::MakeStopName(from)}, {"to", tests::MakeStopName(to)}});
+      }
+    }
+    return requests;
+  }
+
+  std::string Execute(const json::Array &requests, TransportCatalogue &catalogue, RoutingService &routing_service) {
+    SvgInfo properties = MakeRenderSettings();
+    std::ostringstream output;
+    ExecuteRequests(requests, output, catalogue, properties, routing_service);
+    return output.str();
+  }
+
+  void TestCountsHitsAndMisses() {
+    std::mt19937 generator(14);
+    TransportCatalogue catalogue;
+    tests::FillRandomCatalogue(catalogue, generator, 25, 8);
+    // Остановка без маршрутов: ответ "not found" тоже кэшируется
+    const size_t lonely_id = catalogue.GetStopsCount();
+    catalogue.AddStop({tests::MakeStopName(lonely_id), {55.6, 37.6}});
+    RoutingSettings settings;
+    settings.bus_wait_time = 3;
+    settings.bus_velocity = 400;
+
+    const std::vector<std::pair<size_t, size_t>> pairs = {{0, 5}, {3, 17}, {5, 0}, {2, lonely_id}};
+    const auto requests = MakeRouteRequests(pairs, 3);
+
+    RoutingService routing_service(catalogue, settings, ROUTE_CACHE_CAPACITY);
+    const std::string cached_output = Execute(requests, catalogue, routing_service);
+    const RouteCache &route_cache = routing_service.GetRouteCache();
+    ASSERT_EQUAL(route_cache.GetMisses(), pairs.size());
+    ASSERT_EQUAL(route_cache.GetHits(), requests.size() - pairs.size());
+
+    // Ответы из кэша совпадают с ответами без кэша
+    RoutingService uncached_service(catalogue, settings, 0);
+    ASSERT_EQUAL(Execute(requests, catalogue, uncached_service), cached_output);
+    ASSERT_EQUAL(uncached_service.GetRouteCache().GetHits(), 0u);
+    ASSERT_EQUAL(uncached_service.GetRouteCache().GetMisses(), requests.size());
+
+    // Следующий пакет с теми же парами отвечается из кэша целиком
+    Execute(requests, catalogue, routing_service);
+    ASSERT_EQUAL(route_cache.GetMisses(), pairs.size());
+    ASSERT_EQUAL(route_cache.GetHits(), 2 * requests.size() - pairs.size());
+
+    // После изменения справочника кэш очищается, и каждая пара ищется заново один раз
+    catalogue.AddStop({"Another", {55.7, 37.7}});
+    Execute(requests, catalogue, routing_service);
+    ASSERT_EQUAL(route_cache.GetMisses(), 2 * pairs.size());
+    ASSERT_EQUAL(route_cache.GetHits(), 3 * requests.size() - 2 * pairs.size());
+  }
+
+  void TestStatsRequestsBypassCache() {
+    std::mt19937 generator(41);
+    TransportCatalogue catalogue;
+    tests::FillRandomCatalogue(catalogue, generator, 20, 6);
+    RoutingSettings settings;
+    settings.bus_velocity = 500;
+    RoutingService routing_service(catalogue, settings, ROUTE_CACHE_CAPACITY);
+    const json::Array requests = {
+        json::Dict{{"id", 1}, {"type", "Route"}, {"from", tests::MakeStopName(1)}, {"to", tests::MakeStopName(4)},
+                   {"with_stats", true}},
+        json::Dict{{"id", 2}, {"type", "Route"}, {"from", tests::MakeStopName(1)}, {"to", tests::MakeStopName(4)},
+                   {"with_stats", true}}};
+    Execute(requests, catalogue, routing_service);
+    ASSERT_EQUAL(routing_service.GetRouteCache().GetHits(), 0u);
+    ASSERT_EQUAL(routing_service.GetRouteCache().GetMisses(), 0u);
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestCountsHitsAndMisses);
+  RUN_TEST(TestStatsRequestsBypassCache);
+}
@@ -0,0 +1,130 @@
+// Все алгоритмы маршрутизации на случайных сетях дают то же время, что и кратчайший путь
+// по поездкам, собранным прямо из справочника, а маршруты состоят из настоящих поездок.
+// Также проверяются таблица маршрутов и изохрона.
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace transport_catalogue;
+
+namespace {
+
+  struct Network {
+    size_t stops_count;
+    size_t buses_count;
+  };
+
+  // Таблица всех пар во float хранит время с относительной точностью float
+  bool IsCloseTime(double expected, double actual, const RoutingSettings &settings) {
+    if (settings.all_pairs_precision == AllPairsPrecision::FLOAT) {
+      return std::abs(expected - actual) <= 1e-5 * std::max(1., expected);
+    }
+    return tests::IsSameTime(expected, actual);
+  }
+
+  // Изохрона строится ограниченным поиском, а не по таблицам, поэтому время сравнивается
+  // с точностью double при любой точности таблицы всех пар. Границы выбраны между
+  // временами остановок, чтобы погрешность сложения не решала, попадёт ли остановка в ответ.
+  void CheckIsochrone(const TransportRouter &router, const std::vector<double> &expected_times,
+                      graph::VertexId from) {
+    std::vector<double> finite_times;
+    for (const double time: expected_times) {
+      if (!std::isinf(time)) {
+        finite_times.push_back(time);
+      }
+    }
+    std::sort(finite_times.begin(), finite_times.end());
+    for (const size_t rank: {size_t{0}, finite_times.size() / 2, finite_times.size() - 1}) {
+      const double last_time = finite_times[rank];
+      const auto next = std::upper_bound(finite_times.begin(), finite_times.end(),
+                                         last_time + 1e-6 * std::max(1., last_time));
+      const double max_time = next != finite_times.end() ? (last_time + *next) / 2 : last_time + 1;
+      const auto reachable = router.BuildIsochrone(from, max_time);
+      size_t expected_count = 0;
+      for (const double time: expected_times) {
+        expected_count += time <= max_time ? 1 : 0;
+      }
+      ASSERT_EQUAL(reachable.size(), expected_count);
+      for (size_t index = 0; index < reachable.size(); ++index) {
+        const auto &[stop_id, time] = reachable[index];
+        ASSERT(tests::IsSameTime(expected_times[stop_id], time));
+        if (index > 0) {
+          ASSERT(std::pair(reachable[index - 1].second, reachable[index - 1].first) < std::pair(time, stop_id));
+        }
+      }
+    }
+  }
+
+  void CheckRoutes(const TransportCatalogue &catalogue, const RoutingSettings &settings) {
+    const auto rides = tests::CollectRides(catalogue, settings);
+    const size_t stops_count = catalogue.GetStopsCount();
+    const auto expected_times = tests::ComputeReferenceTimes(stops_count, rides);
+    const TransportRouter router(catalogue, settings);
+
+    std::vector<graph::VertexId> all_stops;
+    for (graph::VertexId stop_id = 0; stop_id < stops_count; ++stop_id) {
+      all_stops.push_back(stop_id);
+    }
+    const auto matrix = router.BuildRouteMatrix(all_stops, all_stops);
+    ASSERT_EQUAL(matrix.size(), stops_count);
+
+    for (graph::VertexId from = 0; from < stops_count; ++from) {
+      ASSERT_EQUAL(matrix[from].size(), stops_count);
+      for (graph::VertexId to = 0; to < stops_count; ++to) {
+        const double expected = expected_times[from][to];
+        const auto route = router.BuildRoute(from, to);
+        ASSERT_EQUAL(route.has_value(), !std::isinf(expected));
+        ASSERT_EQUAL(matrix[from][to].has_value(), !std::isinf(expected));
+        if (!route) {
+          continue;
+        }
+        ASSERT(IsCloseTime(expected, route->total_time, settings));
+        ASSERT(IsCloseTime(expected, *matrix[from][to], settings));
+        tests::CheckRouteRides(*route, rides);
+        double total_time = 0;
+        graph::VertexId current = from;
+        for (const auto &leg: route->legs) {
+          ASSERT_EQUAL(leg.from, current);
+          total_time += leg.weight;
+          current = leg.to;
+        }
+        ASSERT_EQUAL(current, to);
+        ASSERT(IsCloseTime(expected, total_time, settings));
+      }
+      CheckIsochrone(router, expected_times[from], from);
+    }
+  }
+
+  void TestEnginesMatchReference() {
+    // Густая сеть, сеть с изолированными частями и сеть с длинными маршрутами
+    const Network networks[] = {{30, 12}, {60, 6}, {45, 25}};
+    std::mt19937 generator(2024);
+    for (const auto &[stops_count, buses_count]: networks) {
+      TransportCatalogue catalogue;
+      tests::FillRandomCatalogue(catalogue, generator, stops_count, buses_count);
+      RoutingSettings settings;
+      settings.bus_wait_time = static_cast<double>(generator() % 7);
+      settings.bus_velocity = 200. + static_cast<double>(generator() % 500);
+      settings.build_threads = 2;
+      settings.matrix_threads = 2;
+      for (const RoutingAlgorithm algorithm: tests::GetAllAlgorithms()) {
+        settings.algorithm = algorithm;
+        settings.all_pairs_precision = AllPairsPrecision::DOUBLE;
+        CheckRoutes(catalogue, settings);
+        if (algorithm == RoutingAlgorithm::ALL_PAIRS) {
+          settings.all_pairs_precision = AllPairsPrecision::FLOAT;
+          CheckRoutes(catalogue, settings);
+        }
+      }
+    }
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestEnginesMatchReference);
+}
@@ -0,0 +1,168 @@
+// Файл базы: справочник, настройки и данные роутера восстанавливаются без изменений,
+// восстановленный роутер отвечает так же, как построенный, а повреждённый файл отвергается
+
+#include "serialization.h"
+#include "test_utils.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace transport_catalogue;
+
+namespace {
+
+  const std::string BASE_PATH = "serialization_test_base.db";
+
+  SvgInfo MakeRenderSettings() {
+    return {1200., 500., 50., 14., 5., 20, {7., 15.}, 18, {7., -3.}, svg::Rgba{255, 255, 255, 0.85}, 3.,
+            {svg::Color{"green"}, svg::Rgb{255, 160, 0}, svg::Color{"red"}}};
+  }
+
+  void CheckSameCatalogue(const TransportCatalogue &expected, const TransportCatalogue &loaded) {
+    ASSERT_EQUAL(loaded.GetStopsCount(), expected.GetStopsCount());
+    for (size_t stop_id = 0; stop_id < expected.GetStopsCount(); ++stop_id) {
+      ASSERT_EQUAL(loaded.GetStopFromId(stop_id), expected.GetStopFromId(stop_id));
+      ASSERT(loaded.GetStopCoordinates(stop_id) == expected.GetStopCoordinates(stop_id));
+    }
+    const auto &expected_buses = expected.GetBusesDequeConst();
+    const auto &loaded_buses = loaded.GetBusesDequeConst();
+    ASSERT_EQUAL(loaded_buses.size(), expected_buses.size());
+    for (size_t bus_id = 0; bus_id < expected_buses.size(); ++bus_id) {
+      ASSERT_EQUAL(loaded_buses[bus_id].name, expected_buses[bus_id].name);
+      ASSERT_EQUAL(loaded_buses[bus_id].is_roundtrip, expected_buses[bus_id].is_roundtrip);
+      ASSERT_EQUAL(loaded_buses[bus_id].stops.size(), expected_buses[bus_id].stops.size());
+      for (size_t index = 0; index < expected_buses[bus_id].stops.size(); ++index) {
+        ASSERT_EQUAL(loaded_buses[bus_id].stops[index]->id, expected_buses[bus_id].stops[index]->id);
+      }
+    }
+    const auto expected_distances = expected.GetDistances();
+    const auto loaded_distances = loaded.GetDistances();
+    ASSERT_EQUAL(loaded_distances.size(), expected_distances.size());
+    for (size_t index = 0; index < expected_distances.size(); ++index) {
+      ASSERT_EQUAL(loaded_distances[index].from, expected_distances[index].from);
+      ASSERT_EQUAL(loaded_distances[index].to, expected_distances[index].to);
+      ASSERT_EQUAL(loaded_distances[index].distance, expected_distances[index].distance);
+    }
+  }
+
+  // Таблицы не пересчитываются после загрузки, поэтому маршруты совпадают в точности
+  void CheckSameRoutes(const TransportRouter &expected, const TransportRouter &loaded, size_t stops_count) {
+    for (graph::VertexId from = 0; from < stops_count; ++from) {
+      for (graph::VertexId to = 0; to < stops_count; ++to) {
+        const auto expected_route = expected.BuildRoute(from, to);
+        const auto route = loaded.BuildRoute(from, to);
+        ASSERT_EQUAL(route.has_value(), expected_route.has_value());
+        if (!route) {
+          continue;
+        }
+        ASSERT_EQUAL(route->total_time, expected_route->total_time);
+        ASSERT_EQUAL(route->legs.size(), expected_route->legs.size());
+        for (size_t index = 0; index < route->legs.size(); ++index) {
+          const auto &leg = route->legs[index];
+          const auto &expected_leg = expected_route->legs[index];
+          ASSERT(leg.from == expected_leg.from && leg.to == expected_leg.to && leg.bus_id == expected_leg.bus_id
+                 && leg.span_count == expected_leg.span_count && leg.weight == expected_leg.weight);
+        }
+      }
+    }
+  }
+
+  void TestRoundTrip(RoutingAlgorithm algorithm, AllPairsPrecision precision) {
+    std::mt19937 generator(static_cast<unsigned>(algorithm) * 2 + static_cast<unsigned>(precision) + 5);
+    TransportCatalogue catalogue;
+    tests::FillRandomCatalogue(catalogue, generator, 40, 14);
+    RoutingSettings settings;
+    settings.bus_wait_time = 4;
+    settings.bus_velocity = 666.6666668;
+    settings.algorithm = algorithm;
+    settings.all_pairs_precision = precision;
+    const TransportRouter router(catalogue, settings);
+    const SvgInfo render_settings = MakeRenderSettings();
+    serialization::SaveBase(BASE_PATH, catalogue, render_settings, router);
+
+    TransportCatalogue loaded_catalogue;
+    auto base = serialization::LoadBase(BASE_PATH, loaded_catalogue);
+    CheckSameCatalogue(catalogue, loaded_catalogue);
+
+    ASSERT_EQUAL(base.routing_settings.bus_wait_time, settings.bus_wait_time);
+    ASSERT_EQUAL(base.routing_settings.bus_velocity, settings.bus_velocity);
+    ASSERT(base.routing_settings.algorithm == algorithm);
+    ASSERT(base.routing_settings.all_pairs_precision == precision);
+    ASSERT_EQUAL(base.render_settings.width, render_settings.width);
+    ASSERT_EQUAL(base.render_settings.stop_label_offset.dy, render_settings.stop_label_offset.dy);
+    ASSERT_EQUAL(base.render_settings.color_palette.size(), render_settings.color_palette.size());
+    ASSERT(std::holds_alternative<svg::Rgba>(base.render_settings.underlayer_color));
+    ASSERT_EQUAL(std::get<svg::Rgba>(base.render_settings.underlayer_color).opacity, 0.85);
+
+    // Таблицы выбранного алгоритма сохраняются в файле, а не строятся при загрузке
+    const bool is_all_pairs = algorithm == RoutingAlgorithm::ALL_PAIRS;
+    ASSERT_EQUAL(base.router_data.all_pairs.has_value(), is_all_pairs && precision == AllPairsPrecision::DOUBLE);
+    ASSERT_EQUAL(base.router_data.compact_all_pairs.has_value(), is_all_pairs && precision == AllPairsPrecision::FLOAT);
+    ASSERT_EQUAL(base.router_data.contraction_hierarchy.has_value(),
+                 algorithm == RoutingAlgorithm::CONTRACTION_HIERARCHIES);
+
+    const TransportRouter loaded_router(loaded_catalogue, base.routing_settings, std::move(base.router_data));
+    CheckSameRoutes(router, loaded_router, catalogue.GetStopsCount());
+  }
+
+  void TestRoundTripForAllAlgorithms() {
+    for (const RoutingAlgorithm algorithm: tests::GetAllAlgorithms()) {
+      TestRoundTrip(algorithm, AllPairsPrecision::DOUBLE);
+    }
+    TestRoundTrip(RoutingAlgorithm::ALL_PAIRS, AllPairsPrecision::FLOAT);
+  }
+
+  bool LoadThrows() {
+    TransportCatalogue catalogue;
+    try {
+      serialization::LoadBase(BASE_PATH, catalogue);
+    } catch (const std::runtime_error &) {
+      return true;
+    }
+    return false;
+  }
+
+  void WriteFile(const std::string &content) {
+    std::ofstream output(BASE_PATH, std::ios::binary | std::ios::trunc);
+    output.write(content.data(), static_cast<std::streamsize>(content.size()));
+  }
+
+  void TestRejectsDamagedFile() {
+    std::mt19937 generator(9);
+    TransportCatalogue catalogue;
+    tests::FillRandomCatalogue(catalogue, generator, 20, 6);
+    RoutingSettings settings;
+    settings.bus_velocity = 500;
+    const TransportRouter router(catalogue, settings);
+    serialization::SaveBase(BASE_PATH, catalogue, MakeRenderSettings(), router);
+    std::string content;
+    {
+      std::ifstream input(BASE_PATH, std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    ASSERT(!LoadThrows());
+
+    for (const size_t position: {size_t{0}, content.size() / 2, content.size() - 1}) {
+      std::string damaged = content;
+      damaged[position] = static_cast<char>(damaged[position] ^ 0x20);
+      WriteFile(damaged);
+      ASSERT(LoadThrows());
+    }
+    WriteFile(content.substr(0, content.size() / 2));
+    ASSERT(LoadThrows());
+    WriteFile({});
+    ASSERT(LoadThrows());
+    std::remove(BASE_PATH.c_str());
+    ASSERT(LoadThrows());
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestRoundTripForAllAlgorithms);
+  RUN_TEST(TestRejectsDamagedFile);
+}
@@ -0,0 +1,129 @@
+// Поиск ближайших точек и точек в радиусе через geo::SpatialIndex совпадает с полным перебором,
+// в том числе у полюсов, через 180-й меридиан и при совпадающих точках
+
+#include "spatial_index.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace transport_catalogue;
+
+namespace {
+
+  // Все точки по возрастанию (расстояние, номер), как упорядочивает индекс
+  std::vector<std::pair<size_t, double>> ScanAll(const std::vector<geo::Coordinates> &points,
+                                                 geo::Coordinates point) {
+    std::vector<std::pair<double, size_t>> found;
+    for (size_t point_id = 0; point_id < points.size(); ++point_id) {
+      double distance = geo::ComputeDistance(point, points[point_id]);
+      if (std::isnan(distance)) {
+        distance = 0;
+      }
+      found.emplace_back(distance, point_id);
+    }
+    std::sort(found.begin(), found.end());
+    std::vector<std::pair<size_t, double>> result;
+    for (const auto &[distance, point_id]: found) {
+      result.emplace_back(point_id, distance);
+    }
+    return result;
+  }
+
+  // Городские точки, разбросанные по сфере, точки у 180-го меридиана и у полюса, повторы
+  std::vector<geo::Coordinates> MakePoints(std::mt19937 &generator) {
+    std::uniform_real_distribution<double> city_lat(55.5, 56.0);
+    std::uniform_real_distribution<double> city_lng(37.3, 37.9);
+    std::uniform_real_distribution<double> lat(-89.9, 89.9);
+    std::uniform_real_distribution<double> lng(-180., 180.);
+    std::vector<geo::Coordinates> points;
+    for (size_t i = 0; i < 1500; ++i) {
+      points.push_back(i % 3 != 0 ? geo::Coordinates{city_lat(generator), city_lng(generator)}
+                                  : geo::Coordinates{lat(generator), lng(generator)});
+    }
+    points.push_back({10., 179.9999});
+    points.push_back({10., -179.9999});
+    points.push_back({89.9999, 0.});
+    points.push_back({89.9999, 180.});
+    points.push_back(points.front());
+    points.push_back(points.front());
+    return points;
+  }
+
+  void TestMatchesLinearScan() {
+    std::mt19937 generator(22);
+    const auto points = MakePoints(generator);
+    const geo::SpatialIndex index(points);
+    ASSERT_EQUAL(index.GetPointsCount(), points.size());
+
+    std::vector<geo::Coordinates> queries = {{10., 180.}, {90., 0.}, {-90., 0.}, points.front(), {55.75, 37.6}};
+    std::uniform_real_distribution<double> city_lat(55.5, 56.0);
+    std::uniform_real_distribution<double> city_lng(37.3, 37.9);
+    std::uniform_real_distribution<double> lat(-90., 90.);
+    std::uniform_real_distribution<double> lng(-180., 180.);
+    for (size_t i = 0; i < 40; ++i) {
+      queries.push_back({city_lat(generator), city_lng(generator)});
+      queries.push_back({lat(generator), lng(generator)});
+    }
+
+    for (const auto &query: queries) {
+      const auto expected = ScanAll(points, query);
+      for (const size_t count: {size_t{0}, size_t{1}, size_t{7}, size_t{50}, points.size() + 10}) {
+        const auto nearest = index.FindNearest(query, count);
+        ASSERT_EQUAL(nearest.size(), std::min(count, points.size()));
+        // При равных расстояниях выбираются точки с меньшими номерами, поэтому ответ совпадает целиком
+        for (size_t i = 0; i < nearest.size(); ++i) {
+          ASSERT_EQUAL(nearest[i].first, expected[i].first);
+          ASSERT_EQUAL(nearest[i].second, expected[i].second);
+        }
+      }
+      for (const double radius: {0., 300., 5000., 2e6, 3e7}) {
+        const auto in_radius = index.FindInRadius(query, radius);
+        const size_t expected_count = std::count_if(expected.begin(), expected.end(), [radius](const auto &entry) {
+          return entry.second <= radius;
+        });
+        ASSERT_EQUAL(in_radius.size(), expected_count);
+        for (size_t i = 0; i < in_radius.size(); ++i) {
+          ASSERT_EQUAL(in_radius[i].first, expected[i].first);
+          ASSERT_EQUAL(in_radius[i].second, expected[i].second);
+        }
+      }
+      ASSERT(index.FindInRadius(query, -1.).empty());
+    }
+  }
+
+  void TestEmptyIndex() {
+    const geo::SpatialIndex index({});
+    ASSERT_EQUAL(index.GetPointsCount(), 0u);
+    ASSERT(index.FindNearest({55.7, 37.6}, 5).empty());
+    ASSERT(index.FindInRadius({55.7, 37.6}, 1e7).empty());
+  }
+
+  // Индекс справочника строится заново после добавления остановки
+  void TestCatalogueRebuildsIndex() {
+    TransportCatalogue catalogue;
+    catalogue.AddStop({"Far", {55.9, 37.9}});
+    catalogue.AddStop({"Middle", {55.75, 37.65}});
+    const geo::Coordinates point{55.7, 37.6};
+    auto nearest = catalogue.FindNearestStops(point, 1);
+    ASSERT_EQUAL(nearest.size(), 1u);
+    ASSERT_EQUAL(catalogue.GetStopFromId(nearest[0].first), "Middle");
+
+    catalogue.AddStop({"Near", {55.7001, 37.6001}});
+    nearest = catalogue.FindNearestStops(point, 1);
+    ASSERT_EQUAL(catalogue.GetStopFromId(nearest[0].first), "Near");
+    ASSERT_EQUAL(nearest[0].second, geo::ComputeDistance(point, {55.7001, 37.6001}));
+    ASSERT_EQUAL(catalogue.FindStopsInRadius(point, 20.).size(), 1u);
+    ASSERT_EQUAL(catalogue.FindStopsInRadius(point, 1e5).size(), 3u);
+  }
+
+}
+
+int main() {
+  RUN_TEST(TestMatchesLinearScan);
+  RUN_TEST(TestEmptyIndex);
+  RUN_TEST(TestCatalogueRebuildsIndex);
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Проверки без сторонних библиотек: первая неудача печатает место и завершает тест с кодом 1
+#define ASSERT(condition) ::tests::AssertImpl((condition), #condition, __FILE__, __LINE__)
+#define ASSERT_EQUAL(lhs, rhs) ::tests::AssertImpl((lhs) == (rhs), #lhs " == " #rhs, __FILE__, __LINE__)
+#define RUN_TEST(function) ::tests::RunTestImpl((function), #function)
+
+namespace tests {
+
+  inline void AssertImpl(bool value, const char *expression, const char *file, int line) {
+    if (!value) {
+      std::cerr << file << ':' << line << ": assertion failed: " << expression << std::endl;
+      std::exit(1);
+    }
+  }
+
+  template<typename Function>
+  void RunTestImpl(Function function, const char *name) {
+    function();
+    std::cerr << name << " OK" << std::endl;
+  }
+
+  // Совпадение времени маршрутов, найденных разными алгоритмами: пути могут отличаться
+  // при равных весах и складываться в другом порядке
+  inline bool IsSameTime(double lhs, double rhs) {
+    return std::abs(lhs - rhs) <= 1e-9 * std::max({1., std::abs(lhs), std::abs(rhs)});
+  }
+
+  inline const std::vector<RoutingAlgorithm> &GetAllAlgorithms() {
+    static const std::vector<RoutingAlgorithm> algorithms = {
+        RoutingAlgorithm::DIJKSTRA, RoutingAlgorithm::ALL_PAIRS, RoutingAlgorithm::CONTRACTION_HIERARCHIES,
+        RoutingAlgorithm::A_STAR, RoutingAlgorithm::RAPTOR};
+    return algorithms;
+  }
+
+  inline std::string MakeStopName(size_t stop_id) {
+    return "Stop " + std::to_string(stop_id);
+  }
+
+  // Некруговой маршрут хранится в справочнике целиком: туда и обратно
+  inline std::vector<transport_catalogue::Stop *> MakeRandomStops(transport_catalogue::TransportCatalogue &catalogue,
+                                                                  std::mt19937 &generator, bool is_roundtrip) {
+    std::uniform_int_distribution<size_t> stop_distribution(0, catalogue.GetStopsCount() - 1);
+    std::uniform_int_distribution<size_t> length_distribution(2, 7);
+    std::vector<transport_catalogue::Stop *> stops;
+    const size_t length = length_distribution(generator);
+    for (size_t index = 0; index < length; ++index) {
+      stops.push_back(catalogue.FindStop(catalogue.GetStopFromId(stop_distribution(generator))));
+    }
+    if (is_roundtrip) {
+      stops.push_back(stops.front());
+    } else {
+      for (size_t index = length - 1; index-- > 0;) {
+        stops.push_back(stops[index]);
+      }
+    }
+    return stops;
+  }
+
+  // Задаёт расстояния для всех соседних остановок маршрута, у некоторых пар - разные в две стороны
+  inline void AddRandomDistances(transport_catalogue::TransportCatalogue &catalogue, std::mt19937 &generator,
+                                 const std::vector<transport_catalogue::Stop *> &stops) {
+    std::uniform_int_distribution<int64_t> distance_distribution(100, 3000);
+    for (size_t index = 0; index + 1 < stops.size(); ++index) {
+      catalogue.SetDistance(distance_distribution(generator), stops[index], stops[index + 1]);
+      if (generator() % 4 == 0) {
+        catalogue.SetDistance(distance_distribution(generator), stops[index + 1], stops[index]);
+      }
+    }
+  }
+
+  // Остановки в квадрате около 20 км и случайные маршруты по ним
+  inline void FillRandomCatalogue(transport_catalogue::TransportCatalogue &catalogue, std::mt19937 &generator,
+                                  size_t stops_count, size_t buses_count) {
+    std::uniform_real_distribution<double> latitude_distribution(55.6, 55.8);
+    std::uniform_real_distribution<double> longitude_distribution(37.5, 37.8);
+    for (size_t stop_id = 0; stop_id < stops_count; ++stop_id) {
+      catalogue.AddStop({MakeStopName(stop_id),
+                         {latitude_distribution(generator), longitude_distribution(generator)}});
+    }
+    for (size_t bus_id = 0; bus_id < buses_count; ++bus_id) {
+      const bool is_roundtrip = generator() % 2 == 0;
+      auto stops = MakeRandomStops(catalogue, generator, is_roundtrip);
+      AddRandomDistances(catalogue, generator, stops);
+      catalogue.AddBus({"Bus " + std::to_string(bus_id), std::move(stops), is_roundtrip});
+    }
+  }
+
+  // Маршрут ведёт из from в to, поездки стыкуются, а их суммарное время равно total_time
+  inline void CheckRouteConsistency(const TransportRouter::Route &route, graph::VertexId from, graph::VertexId to) {
+    double total_time = 0;
+    graph::VertexId current = from;
+    for (const auto &leg: route.legs) {
+      ASSERT_EQUAL(leg.from, current);
+      ASSERT(leg.span_count > 0);
+      total_time += leg.weight;
+      current = leg.to;
+    }
+    ASSERT_EQUAL(current, to);
+    ASSERT(IsSameTime(total_time, route.total_time));
+  }
+
+  // Поездка на одном маршруте без пересадок: (from, to, bus_id, span_count) -> время с ожиданием.
+  // Собирается прямо по справочнику, независимо от построения графа в TransportRouter.
+  using Rides = std::multimap<std::tuple<graph::VertexId, graph::VertexId, uint32_t, int>, double>;
+
+  inline Rides CollectRides(const transport_catalogue::TransportCatalogue &catalogue,
+                            const RoutingSettings &settings) {
+    Rides rides;
+    auto add_ride = [&](const transport_catalogue::Bus &bus, size_t first, size_t last, bool backward) {
+      int64_t distance = 0;
+      for (size_t index = std::min(first, last); index < std::max(first, last); ++index) {
+        distance += backward ? catalogue.GetDistance(bus.stops[index + 1], bus.stops[index])
+                             : catalogue.GetDistance(bus.stops[index], bus.stops[index + 1]);
+      }
+      rides.emplace(std::tuple{bus.stops[first]->id, bus.stops[last]->id, bus.id,
+                               static_cast<int>(std::max(first, last) - std::min(first, last))},
+                    settings.bus_wait_time + static_cast<double>(distance) / settings.bus_velocity);
+    };
+    for (const auto &bus: catalogue.GetBusesDequeConst()) {
+      // Некруговой маршрут не проезжает через конечную: поездки только внутри одной половины
+      const size_t count = bus.is_roundtrip ? bus.stops.size() : bus.stops.size() / 2 + 1;
+      for (size_t first = 0; first < count && !bus.stops.empty(); ++first) {
+        for (size_t last = 0; last < count; ++last) {
+          if (first < last || (first > last && !bus.is_roundtrip)) {
+            add_ride(bus, first, last, first > last);
+          }
+        }
+      }
+    }
+    return rides;
+  }
+
+  // Время кратчайшего маршрута между всеми парами остановок по поездкам, infinity - недостижимо
+  inline std::vector<std::vector<double>> ComputeReferenceTimes(size_t stops_count, const Rides &rides) {
+    std::vector<std::vector<double>> times(stops_count,
+                                           std::vector<double>(stops_count, std::numeric_limits<double>::infinity()));
+    for (size_t stop_id = 0; stop_id < stops_count; ++stop_id) {
+      times[stop_id][stop_id] = 0;
+    }
+    for (const auto &[ride, time]: rides) {
+      double &current = times[std::get<0>(ride)][std::get<1>(ride)];
+      current = std::min(current, time);
+    }
+    for (size_t through = 0; through < stops_count; ++through) {
+      for (size_t from = 0; from < stops_count; ++from) {
+        for (size_t to = 0; to < stops_count; ++to) {
+          times[from][to] = std::min(times[from][to], times[from][through] + times[through][to]);
+        }
+      }
+    }
+    return times;
+  }
+
+  // Каждая поездка маршрута действительно есть в справочнике с тем же временем
+  inline void CheckRouteRides(const TransportRouter::Route &route, const Rides &rides) {
+    for (const auto &leg: route.legs) {
+      const auto [begin, end] = rides.equal_range(std::tuple{leg.from, leg.to, leg.bus_id, leg.span_count});
+      ASSERT(std::any_of(begin, end, [&leg](const auto &ride) {
+        return IsSameTime(ride.second, leg.weight);
+      }));
+    }
+  }
+
+}  // namespace tests
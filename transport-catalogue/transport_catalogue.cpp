@@ -1,117 +1,314 @@
 #include "transport_catalogue.h"
 #include "geo.h"
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include <set>
-#include <iostream>
+#include <stdexcept>
 
 namespace transport_catalogue {
-  void TransportCatalogue::AddStop(const Stop &stop) {
-    stops_.push_back(stop);
-    Stop *stop_ptr = &stops_.back();
-    stopname_to_stop_.insert({std::string_view{stops_.back().name}, stop_ptr});
-    stop_name_to_id[std::string_view{stops_.back().name}] = stop_count++;
+  namespace {
+    // Номера хранятся в 32 битах
+    uint32_t MakeId(size_t count) {
+      if (count >= std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Too many catalogue entries for 32-bit ids");
+      }
+      return static_cast<uint32_t>(count);
+    }
+  }
 
-    id_to_stopname[stop_name_to_id[stop.name]] = stop.name;
+  Stop *TransportCatalogue::AddStop(const Stop &stop) {
+    const uint32_t stop_id = MakeId(stops_.size());
+    stops_.push_back({stop.name, stop.coordinates, stop_id});
+    stop_ids_.insert({std::string_view{stops_.back().name}, stop_id});
+    stop_prepared_coordinates_.push_back(geo::PrepareCoordinates(stop.coordinates));
+    stop_buses_.emplace_back();
+    spatial_index_.reset();
+    ++version_;
+    return &stops_.back();
   }
 
-  Stop *TransportCatalogue::FindStop(const std::string &name_of_stop) {
-    if (stopname_to_stop_.count(name_of_stop)) {
-      return stopname_to_stop_.at(name_of_stop);
+  Stop *TransportCatalogue::FindStop(std::string_view name_of_stop) {
+    if (auto it = stop_ids_.find(name_of_stop); it != stop_ids_.end()) {
+      return &stops_[it->second];
     } else {
       return nullptr;
     }
   }
 
   void TransportCatalogue::AddBus(const Bus &bus) {
-    buses_.push_back(bus);
-    Bus *bus_ptr = &buses_.back();
-    busname_to_bus_.insert({std::string_view{buses_.back().name}, bus_ptr});
-    roundtrip_of_buses.insert({std::string_view{buses_.back().name}, bus.is_roundtrip});
+    const uint32_t bus_id = MakeId(buses_.size());
+    buses_.push_back({bus.name, bus.stops, bus.is_roundtrip, bus_id});
+    bus_ids_.insert({std::string_view{buses_.back().name}, bus_id});
 
-    for (auto &stop: bus_ptr->stops) {
-      unique_stops.insert(std::string_view{stop->name});
+    for (const Stop *stop: bus.stops) {
+      // Список остановки остаётся упорядоченным по названию, повтор стоит на месте вставки
+      auto &buses = stop_buses_.at(stop->id);
+      const auto it = std::lower_bound(buses.begin(), buses.end(), bus_id, [this](uint32_t lhs, uint32_t rhs) {
+        return IsBusNameLess(lhs, rhs);
+      });
+      if (it == buses.end() || *it != bus_id) {
+        buses.insert(it, bus_id);
+      }
     }
+    ++version_;
   }
 
-  Bus *TransportCatalogue::FindBus(const std::string &name_of_bus) {
-    if (busname_to_bus_.count(name_of_bus)) {
-      return busname_to_bus_.at(name_of_bus);
+  Bus *TransportCatalogue::FindBus(std::string_view name_of_bus) {
+    if (auto it = bus_ids_.find(name_of_bus); it != bus_ids_.end()) {
+      return &buses_[it->second];
     } else
       return nullptr;
   }
 
-  template<typename Type>
-  std::set<Type> MakeSet(std::vector<Type> &query_words) {
-    std::set<Type> s(query_words.begin(), query_words.end());
-    return s;
+  const BusInfo &TransportCatalogue::GetBusInfo(std::string_view name_of_bus) {
+    const uint32_t bus_id = bus_ids_.at(name_of_bus);
+    if (bus_infos_.size() < buses_.size()) {
+      bus_infos_.resize(buses_.size());
+    }
+    auto &bus_info = bus_infos_[bus_id];
+    if (!bus_info) {
+      bus_info = ComputeBusInfo(buses_[bus_id]);
+      has_bus_infos_ = true;
+    }
+    return *bus_info;
   }
 
-  BusInfo TransportCatalogue::GetBusInfo(const std::string &name_of_bus) {
-    auto bus_address = busname_to_bus_.at(name_of_bus);
-    size_t numb_of_stops = bus_address->stops.size();
-    size_t numb_of_unique_stops = MakeSet(bus_address->stops).size();
-    auto &stops_vector = bus_address->stops;
+  BusInfo TransportCatalogue::ComputeBusInfo(const Bus &bus) const {
+    const auto &stops_vector = bus.stops;
+    size_t numb_of_stops = stops_vector.size();
+    std::vector<uint32_t> stop_ids;
+    stop_ids.reserve(stops_vector.size());
+    for (const Stop *stop: stops_vector) {
+      stop_ids.push_back(stop->id);
+    }
+    std::sort(stop_ids.begin(), stop_ids.end());
+    size_t numb_of_unique_stops = std::unique(stop_ids.begin(), stop_ids.end()) - stop_ids.begin();
     double result_dist = 0;
     int64_t real_dist = 0;
-    for (size_t count = 0; count < stops_vector.size() - 1; count++) {
+    for (size_t count = 0; count + 1 < stops_vector.size(); count++) {
       result_dist += geo::ComputeDistance(stops_vector[count]->coordinates, stops_vector[count + 1]->coordinates);
       real_dist += GetDistance(stops_vector[count], stops_vector[count + 1]);
     }
-    return {numb_of_stops, numb_of_unique_stops, result_dist, real_dist};
+    return {numb_of_stops, numb_of_unique_stops, result_dist, real_dist, real_dist / result_dist};
   }
 
-  StopInfo TransportCatalogue::GetStopInfo(const std::string &name_of_stop) {
-    if (stopname_to_buses.count(stopname_to_stop_.at(std::string_view{name_of_stop}))) {
-      return {stopname_to_buses.at(stopname_to_stop_.at(std::string_view{name_of_stop}))};
-    } else {
-      return StopInfo{};
-    }
+  StopInfo TransportCatalogue::GetStopInfo(std::string_view name_of_stop) const {
+    return {ranges::AsRange(stop_buses_[stop_ids_.at(name_of_stop)])};
   }
 
-  std::unordered_map<Stop *, std::set<std::string_view>> &TransportCatalogue::GetStopsToBusesMap() {
-    return stopname_to_buses;
-  }
-
-  std::deque<Bus> &TransportCatalogue::GetBusesDeque() {
+  const std::deque<Bus> &TransportCatalogue::GetBusesDequeConst() const {
     return buses_;
   }
 
-  const std::deque<Bus> &TransportCatalogue::GetBusesDequeConst() const {
-    return buses_;
+  const Bus &TransportCatalogue::GetBusFromId(size_t bus_id) const {
+    return buses_.at(bus_id);
   }
 
   void TransportCatalogue::SetDistance(int64_t dist, Stop *from, Stop *to) {
-    dist_betw_stops_[{from, to}] = dist;
+    ++version_;
+    // Длины маршрутов зависят от расстояний, поэтому посчитанная статистика сбрасывается
+    if (has_bus_infos_) {
+      bus_infos_.assign(bus_infos_.size(), std::nullopt);
+      has_bus_infos_ = false;
+    }
+    // Пары из индекса не бывают среди новых, поэтому индекс не нужно перестраивать
+    auto *entry = const_cast<DistanceEntry *>(FindDistanceEntry(from->id, to->id));
+    if (!entry) {
+      pending_distances_.push_back({from->id, to->id, dist});
+      has_pending_distances_.store(true, std::memory_order_release);
+      return;
+    }
+    entry->distance = dist;
+    entry->is_explicit = true;
+    // Обратное направление, взятое из этого расстояния, обновляется вместе с ним
+    auto *reverse = const_cast<DistanceEntry *>(FindDistanceEntry(to->id, from->id));
+    if (reverse && !reverse->is_explicit) {
+      reverse->distance = dist;
+    }
   }
 
   int64_t TransportCatalogue::GetDistance(Stop *from, Stop *to) const {
-    if ((from == to) && (!dist_betw_stops_.count({from, to}))) {
+    EnsureDistanceIndex();
+    if (const DistanceEntry *entry = FindDistanceEntry(from->id, to->id)) {
+      return entry->distance;
+    }
+    if (from == to) {
       return 0;
     }
-    if (dist_betw_stops_.count({from, to})) {
-      return dist_betw_stops_.at({from, to});
-    } else {
-      return dist_betw_stops_.at({to, from});
+    throw std::out_of_range("Distance between " + from->name + " and " + to->name + " is not set");
+  }
+
+  std::vector<StopsDistance> TransportCatalogue::GetDistances() const {
+    EnsureDistanceIndex();
+    return CollectExplicitDistances();
+  }
+
+  std::vector<StopsDistance> TransportCatalogue::CollectExplicitDistances() const {
+    // Индекс упорядочен по остановке-источнику и соседу
+    std::vector<StopsDistance> result;
+    for (size_t from = 0; from + 1 < distance_offsets_.size(); ++from) {
+      for (size_t index = distance_offsets_[from]; index < distance_offsets_[from + 1]; ++index) {
+        const DistanceEntry &entry = distance_entries_[index];
+        if (entry.is_explicit) {
+          result.push_back({from, entry.to, entry.distance});
+        }
+      }
+    }
+    return result;
+  }
+
+  const TransportCatalogue::DistanceEntry *TransportCatalogue::FindDistanceEntry(uint32_t from, uint32_t to) const {
+    if (from + 1 >= distance_offsets_.size()) {
+      return nullptr;
+    }
+    // У остановки обычно несколько соседей, поэтому двоичный поиск идёт по короткому непрерывному отрезку
+    const auto begin = distance_entries_.begin() + static_cast<std::ptrdiff_t>(distance_offsets_[from]);
+    const auto end = distance_entries_.begin() + static_cast<std::ptrdiff_t>(distance_offsets_[from + 1]);
+    const auto it = std::lower_bound(begin, end, to, [](const DistanceEntry &entry, uint32_t stop_id) {
+      return entry.to < stop_id;
+    });
+    return it != end && it->to == to ? &*it : nullptr;
+  }
+
+  void TransportCatalogue::EnsureDistanceIndex() const {
+    // Индекс собирается один раз после загрузки, дальше проверка - одно чтение флага.
+    // Сборка под мьютексом, так как граф маршрутов строится из нескольких потоков.
+    if (!has_pending_distances_.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::lock_guard guard(distance_index_mutex_);
+    if (has_pending_distances_.load(std::memory_order_relaxed)) {
+      BuildDistanceIndex();
+      has_pending_distances_.store(false, std::memory_order_release);
     }
   }
 
+  void TransportCatalogue::BuildDistanceIndex() const {
+    // Заданные расстояния: из индекса и новые в порядке задания, при повторе пары побеждает последнее
+    std::vector<StopsDistance> explicit_distances = CollectExplicitDistances();
+    explicit_distances.insert(explicit_distances.end(), pending_distances_.begin(), pending_distances_.end());
+    pending_distances_.clear();
+    pending_distances_.shrink_to_fit();
+
+    // Каждое расстояние даёт запись у источника и запись обратного направления у цели.
+    // Записи раскладываются подсчётом, порядок задания внутри остановки сохраняется.
+    std::vector<size_t> offsets(stops_.size() + 1, 0);
+    for (const StopsDistance &distance: explicit_distances) {
+      ++offsets[distance.from + 1];
+      ++offsets[distance.to + 1];
+    }
+    for (size_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+      offsets[stop_id + 1] += offsets[stop_id];
+    }
+    std::vector<DistanceEntry> entries(offsets.back());
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for (const StopsDistance &distance: explicit_distances) {
+      entries[next[distance.from]++] = {static_cast<uint32_t>(distance.to), true, distance.distance};
+      entries[next[distance.to]++] = {static_cast<uint32_t>(distance.from), false, distance.distance};
+    }
+
+    // Внутри остановки сортируем по соседу и оставляем одну запись на соседа: заданное
+    // направление важнее обратного, из равных - последнее заданное
+    distance_offsets_.assign(stops_.size() + 1, 0);
+    size_t size = 0;
+    for (size_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+      const auto begin = entries.begin() + static_cast<std::ptrdiff_t>(offsets[stop_id]);
+      const auto end = entries.begin() + static_cast<std::ptrdiff_t>(offsets[stop_id + 1]);
+      std::stable_sort(begin, end, [](const DistanceEntry &lhs, const DistanceEntry &rhs) {
+        return std::pair{lhs.to, lhs.is_explicit} < std::pair{rhs.to, rhs.is_explicit};
+      });
+      for (auto it = begin; it != end; ++it) {
+        if (it + 1 == end || (it + 1)->to != it->to) {
+          entries[size++] = *it;
+        }
+      }
+      distance_offsets_[stop_id + 1] = size;
+    }
+    entries.resize(size);
+    entries.shrink_to_fit();
+    distance_entries_ = std::move(entries);
+  }
+
   const std::deque<Bus> &TransportCatalogue::GetAllBuses() {
     return buses_;
   }
 
-  std::set<std::string_view> &TransportCatalogue::GetUniqueStops() {
-    return unique_stops;
+  std::set<std::string_view> TransportCatalogue::GetUniqueStops() const {
+    std::set<std::string_view> result;
+    for (size_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+      if (!stop_buses_[stop_id].empty()) {
+        result.insert(stops_[stop_id].name);
+      }
+    }
+    return result;
   }
 
   size_t TransportCatalogue::GetStopId(std::string_view stop_name) const {
-    return stop_name_to_id.at(stop_name);
+    return stop_ids_.at(stop_name);
+  }
+
+  const std::string &TransportCatalogue::GetStopFromId(size_t stop_id) const {
+    return stops_.at(stop_id).name;
+  }
+
+  geo::Coordinates TransportCatalogue::GetStopCoordinates(size_t stop_id) const {
+    return stops_.at(stop_id).coordinates;
+  }
+
+  const geo::PreparedCoordinates &TransportCatalogue::GetStopPreparedCoordinates(size_t stop_id) const {
+    return stop_prepared_coordinates_.at(stop_id);
+  }
+
+  const std::vector<uint32_t> &TransportCatalogue::GetStopBuses(size_t stop_id) const {
+    return stop_buses_.at(stop_id);
+  }
+
+  std::vector<std::pair<size_t, double>> TransportCatalogue::FindNearestStops(geo::Coordinates point,
+                                                                            size_t count) const {
+    return GetSpatialIndex().FindNearest(point, count);
+  }
+
+  std::vector<std::pair<size_t, double>> TransportCatalogue::FindStopsInRadius(geo::Coordinates point,
+                                                                             double radius) const {
+    return GetSpatialIndex().FindInRadius(point, radius);
   }
 
-  std::string TransportCatalogue::GetStopFromId(size_t stop_id) const {
-    return id_to_stopname.at(stop_id);
+  const geo::SpatialIndex &TransportCatalogue::GetSpatialIndex() const {
+    // Запросы к справочнику могут идти из нескольких потоков, поэтому сборка под мьютексом
+    std::lock_guard guard(spatial_index_mutex_);
+    if (!spatial_index_) {
+      std::vector<geo::Coordinates> coordinates;
+      coordinates.reserve(stops_.size());
+      for (const Stop &stop: stops_) {
+        coordinates.push_back(stop.coordinates);
+      }
+      spatial_index_ = std::make_unique<const geo::SpatialIndex>(coordinates);
+    }
+    return *spatial_index_;
+  }
+
+  std::vector<uint32_t> TransportCatalogue::GetCommonBuses(size_t first_stop_id, size_t second_stop_id) const {
+    const auto &first = stop_buses_.at(first_stop_id);
+    const auto &second = stop_buses_.at(second_stop_id);
+    std::vector<uint32_t> result;
+    std::set_intersection(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(result),
+                          [this](uint32_t lhs, uint32_t rhs) {
+                            return IsBusNameLess(lhs, rhs);
+                          });
+    return result;
+  }
+
+  bool TransportCatalogue::IsBusNameLess(uint32_t lhs, uint32_t rhs) const {
+    return buses_[lhs].name < buses_[rhs].name;
   }
 
   size_t TransportCatalogue::GetStopsCount() const {
     return stops_.size();
   }
 
-}
\ No newline at end of file
+  uint64_t TransportCatalogue::GetVersion() const {
+    return version_;
+  }
+
+}
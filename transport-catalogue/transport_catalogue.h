@@ -2,70 +2,141 @@
 
 #include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <set>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include "geo.h"
 #include "domain.h"
+#include "spatial_index.h"
 
 namespace transport_catalogue {
+  // Остановки и маршруты получают плотные 32-битные номера в порядке добавления.
+  // Имя разрешается в номер через единственный индекс, все остальные атрибуты лежат
+  // в массивах, индексируемых номером.
   class TransportCatalogue {
   public:
-    void AddStop(const Stop &stop);
+    // Остановке назначается следующий номер, поле stop.id игнорируется.
+    // Возвращает добавленную остановку, указатель действителен всё время жизни справочника.
+    Stop *AddStop(const Stop &stop);
 
-    Stop *FindStop(const std::string &name_of_stop);
+    Stop *FindStop(std::string_view name_of_stop);
 
+    // Маршруту назначается следующий номер, поле bus.id игнорируется
     void AddBus(const Bus &bus);
 
-    Bus *FindBus(const std::string &name_of_bus);
+    Bus *FindBus(std::string_view name_of_bus);
 
-    BusInfo GetBusInfo(const std::string &name_of_bus);
+    // Статистика считается при первом запросе маршрута и хранится до изменения расстояний,
+    // повторные запросы выполняются за O(1)
+    const BusInfo &GetBusInfo(std::string_view name_of_bus);
 
-    StopInfo GetStopInfo(const std::string &name_of_stop);
-
-    std::unordered_map<Stop *, std::set<std::string_view>> &GetStopsToBusesMap();
-
-    std::deque<Bus> &GetBusesDeque();
+    StopInfo GetStopInfo(std::string_view name_of_stop) const;
 
     const std::deque<Bus> &GetBusesDequeConst() const;
 
+    // Идентификатор маршрута совпадает с порядком его добавления
+    const Bus &GetBusFromId(size_t bus_id) const;
+
+    // Новые пары остановок копятся и попадают в индекс расстояний при первом следующем
+    // запросе, расстояние для уже известной пары обновляется на месте
     void SetDistance(int64_t dist, Stop *from, Stop *to);
 
+    // Расстояние from -> to, а если оно не задано - to -> from. Для остановки до самой себя
+    // без заданного расстояния - 0. Для остальных пар без расстояния бросает std::out_of_range.
     int64_t GetDistance(Stop *from, Stop *to) const;
 
+    // Все заданные расстояния, упорядоченные по идентификаторам остановок
+    std::vector<StopsDistance> GetDistances() const;
+
     const std::deque<Bus> &GetAllBuses();
 
-    std::set<std::string_view> &GetUniqueStops();
+    // Названия остановок, через которые проходит хотя бы один маршрут, по алфавиту
+    std::set<std::string_view> GetUniqueStops() const;
 
     size_t GetStopId(std::string_view stop_name) const;
 
-    std::string GetStopFromId(size_t stop_id) const;
+    const std::string &GetStopFromId(size_t stop_id) const;
+
+    geo::Coordinates GetStopCoordinates(size_t stop_id) const;
+
+    // Координаты с синусами и косинусами, посчитанными при добавлении остановки
+    const geo::PreparedCoordinates &GetStopPreparedCoordinates(size_t stop_id) const;
+
+    // Номера маршрутов, проходящих через остановку, в алфавитном порядке названий
+    const std::vector<uint32_t> &GetStopBuses(size_t stop_id) const;
+
+    // Маршруты, проходящие через обе остановки, в алфавитном порядке названий
+    std::vector<uint32_t> GetCommonBuses(size_t first_stop_id, size_t second_stop_id) const;
 
     size_t GetStopsCount() const;
 
-  private:
-    struct StopsHasher {
-      size_t operator()(std::pair<Stop *, Stop *> elem) const {
-        return s_hasher(elem.first) + 37 * s_hasher(elem.second);
-      }
+    // Не более count ближайших к point остановок: номер остановки и расстояние в метрах
+    // по возрастанию расстояния. Индекс по координатам собирается при первом запросе
+    // после добавления остановок.
+    std::vector<std::pair<size_t, double>> FindNearestStops(geo::Coordinates point, size_t count) const;
+
+    // Остановки не дальше radius метров от point в том же порядке
+    std::vector<std::pair<size_t, double>> FindStopsInRadius(geo::Coordinates point, double radius) const;
 
-    private:
-      std::hash<Stop *> s_hasher;
+    // Увеличивается при каждом добавлении остановки, маршрута или расстояния
+    uint64_t GetVersion() const;
+
+  private:
+    // Запись индекса расстояний: соседняя остановка, расстояние до неё и признак того,
+    // что расстояние задано в этом направлении, а не взято из обратного
+    struct DistanceEntry {
+      uint32_t to;
+      bool is_explicit;
+      int64_t distance;
     };
 
+    // Позиция записи from -> to в индексе или nullptr
+    const DistanceEntry *FindDistanceEntry(uint32_t from, uint32_t to) const;
+
+    // Заданные расстояния из индекса без учёта новых пар
+    std::vector<StopsDistance> CollectExplicitDistances() const;
+
+    // Перестраивает индекс, если есть добавленные после последней сборки пары
+    void EnsureDistanceIndex() const;
+
+    void BuildDistanceIndex() const;
+
+    const geo::SpatialIndex &GetSpatialIndex() const;
+
+    bool IsBusNameLess(uint32_t lhs, uint32_t rhs) const;
+
+    BusInfo ComputeBusInfo(const Bus &bus) const;
+
+    // Записи не перемещаются при добавлении, поэтому указатели на них и string_view на имена
+    // остаются действительными. Номер записи равен её индексу.
     std::deque<Stop> stops_;
     std::deque<Bus> buses_;
-    std::set<std::string_view> unique_stops;
-    std::unordered_map<std::string_view, Stop *> stopname_to_stop_;
-    std::unordered_map<std::string_view, Bus *> busname_to_bus_;
-    std::unordered_map<Stop *, std::set<std::string_view>> stopname_to_buses;
-    std::unordered_map<std::string_view, bool> isbusroundtrip;
-    std::unordered_map<std::pair<Stop *, Stop *>, int64_t, StopsHasher> dist_betw_stops_;
-    std::unordered_map<std::string_view, bool> roundtrip_of_buses;
-    std::unordered_map<std::string_view, size_t> stop_name_to_id;
-    std::unordered_map<size_t, std::string> id_to_stopname;
-    size_t stop_count = 0;
+    std::unordered_map<std::string_view, uint32_t> stop_ids_;
+    std::unordered_map<std::string_view, uint32_t> bus_ids_;
+    std::vector<geo::PreparedCoordinates> stop_prepared_coordinates_;
+    // stop_buses_[stop_id] - маршруты через остановку без повторов, упорядоченные по названию
+    std::vector<std::vector<uint32_t>> stop_buses_;
+    // Расстояния в форме CSR: соседи остановки s - distance_entries_[distance_offsets_[s]..distance_offsets_[s + 1]),
+    // упорядочены по номеру соседа. Обратное направление уже разрешено при сборке.
+    mutable std::vector<size_t> distance_offsets_;
+    mutable std::vector<DistanceEntry> distance_entries_;
+    // Заданные расстояния для пар, которых ещё нет в индексе, в порядке задания
+    mutable std::vector<StopsDistance> pending_distances_;
+    mutable std::atomic<bool> has_pending_distances_ = false;
+    mutable std::mutex distance_index_mutex_;
+    // bus_infos_[bus_id] - посчитанная статистика маршрута
+    std::vector<std::optional<BusInfo>> bus_infos_;
+    bool has_bus_infos_ = false;
+    // Индекс по координатам всех остановок, nullptr - остановки менялись после сборки
+    mutable std::unique_ptr<const geo::SpatialIndex> spatial_index_;
+    mutable std::mutex spatial_index_mutex_;
+    uint64_t version_ = 0;
   };
 
-}
\ No newline at end of file
+}
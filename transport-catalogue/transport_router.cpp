@@ -1,76 +1,521 @@
 #include "transport_router.h"
+#include "parallel.h"
 
-graph::DirectedWeightedGraph<double> TransportRouter::BuildGraph() {
-  graph::DirectedWeightedGraph<double> result(catalogue_.GetStopsCount());
-  const auto curr_buses = catalogue_.GetBusesDequeConst();
-  for (auto &bus: curr_buses) {
-    const auto curr_stops = bus.stops;
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue &catalogue,
+                                 const RoutingSettings &settings)
+    : catalogue_(catalogue), settings_(settings), graph_(BuildGraph()) {
+  Data data;
+  InitializeRouter(data);
+}
+
+TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue &catalogue,
+                                 const RoutingSettings &settings, Data data)
+    : catalogue_(catalogue), settings_(settings), graph_(std::move(data.graph)) {
+  if (graph_.GetVertexCount() != catalogue_.GetStopsCount()) {
+    throw std::invalid_argument("Routing graph does not match the catalogue");
+  }
+  InitializeRouter(data);
+}
+
+TransportRouter::Data TransportRouter::GetData() const {
+  Data result{graph_.GetArrays(), std::nullopt, std::nullopt, std::nullopt};
+  if (all_pairs_router_) {
+    result.all_pairs = all_pairs_router_->GetData();
+  }
+  if (compact_all_pairs_router_) {
+    result.compact_all_pairs = compact_all_pairs_router_->GetData();
+  }
+  if (contraction_hierarchy_) {
+    result.contraction_hierarchy = contraction_hierarchy_->GetData();
+  }
+  return result;
+}
+
+void TransportRouter::InitializeRouter(Data &data) {
+  switch (settings_.algorithm) {
+    case RoutingAlgorithm::ALL_PAIRS:
+      if (settings_.all_pairs_precision == AllPairsPrecision::FLOAT) {
+        compact_all_pairs_router_ = data.compact_all_pairs
+                                    ? std::make_unique<graph::AllPairsRouter<double, float>>(
+                graph_, std::move(*data.compact_all_pairs))
+                                    : std::make_unique<graph::AllPairsRouter<double, float>>(graph_);
+      } else {
+        all_pairs_router_ = data.all_pairs
+                            ? std::make_unique<graph::AllPairsRouter<double>>(graph_, std::move(*data.all_pairs))
+                            : std::make_unique<graph::AllPairsRouter<double>>(graph_);
+      }
+      break;
+    case RoutingAlgorithm::CONTRACTION_HIERARCHIES:
+      contraction_hierarchy_ = data.contraction_hierarchy
+                               ? std::make_unique<graph::ContractionHierarchy<double>>(
+              graph_, std::move(*data.contraction_hierarchy))
+                               : std::make_unique<graph::ContractionHierarchy<double>>(graph_);
+      break;
+    case RoutingAlgorithm::RAPTOR:
+      InitializeRaptorRouter();
+      break;
+    case RoutingAlgorithm::A_STAR:
+      InitializeAStarHeuristic();
+      router_ = std::make_unique<graph::Router<double>>(graph_);
+      break;
+    default:
+      router_ = std::make_unique<graph::Router<double>>(graph_);
+      break;
+  }
+}
 
-    // круговой маршрут
-    if (bus.is_roundtrip) {
-      AddRoundtripBusToGtaph(result, bus);
+void TransportRouter::InitializeAStarHeuristic() {
+  stop_coordinates_.reserve(graph_.GetVertexCount());
+  for (graph::VertexId vertex = 0; vertex < graph_.GetVertexCount(); ++vertex) {
+    stop_coordinates_.push_back(catalogue_.GetStopPreparedCoordinates(vertex));
+  }
+  // Оценка 1 / bus_velocity допустима, только если дорожные расстояния не короче
+  // расстояний по прямой, а справочник этого не гарантирует. Поэтому берём
+  // минимальное по всем рёбрам время на метр прямого расстояния: по неравенству
+  // треугольника такая оценка допустима и монотонна.
+  // Расстояния считаются пакетами, чтобы буферы не росли с числом рёбер
+  constexpr size_t BATCH_SIZE = 1024;
+  const size_t edge_count = graph_.GetEdgeCount();
+  std::vector<geo::PreparedCoordinates> sources(BATCH_SIZE);
+  std::vector<geo::PreparedCoordinates> targets(BATCH_SIZE);
+  std::vector<double> distances(BATCH_SIZE);
+  std::optional<double> minutes_per_meter;
+  for (graph::EdgeId batch_begin = 0; batch_begin < edge_count; batch_begin += BATCH_SIZE) {
+    const size_t batch_size = std::min(BATCH_SIZE, edge_count - batch_begin);
+    for (size_t index = 0; index < batch_size; ++index) {
+      sources[index] = stop_coordinates_[graph_.GetEdgeSource(batch_begin + index)];
+      targets[index] = stop_coordinates_[graph_.GetEdgeTarget(batch_begin + index)];
+    }
+    geo::ComputeDistances(sources.data(), targets.data(), distances.data(), batch_size);
+    for (size_t index = 0; index < batch_size; ++index) {
+      const graph::EdgeId edge_id = batch_begin + index;
+      const double distance = distances[index];
+      if (distance > 0) {
+        minutes_per_meter = std::min(minutes_per_meter.value_or(graph_.GetEdgeWeight(edge_id) / distance),
+                                     graph_.GetEdgeWeight(edge_id) / distance);
+      }
     }
+  }
+  minutes_per_meter_ = minutes_per_meter.value_or(0);
+}
+
+void TransportRouter::InitializeRaptorRouter() {
+  std::vector<raptor::Pattern> patterns;
+  const size_t buses_count = catalogue_.GetBusesDequeConst().size();
+  for (size_t bus_id = 0; bus_id < buses_count; ++bus_id) {
+    if (bus_id >= is_bus_removed_.size() || !is_bus_removed_[bus_id]) {
+      AddBusPatterns(patterns, bus_id);
+    }
+  }
+  raptor_router_ = std::make_unique<raptor::Router>(catalogue_.GetStopsCount(), std::move(patterns),
+                                                    settings_.bus_wait_time, settings_.bus_velocity);
+}
+
+std::optional<TransportRouter::Route> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to,
+                                                                 graph::SearchStats *stats) const {
+  if (raptor_router_) {
+    auto journey = raptor_router_->BuildRoute(from, to);
+    if (!journey) {
+      return std::nullopt;
+    }
+    return Route{journey->total_time, std::move(journey->legs)};
+  }
+  std::optional<graph::Router<double>::RouteInfo> route_info;
+  if (settings_.algorithm == RoutingAlgorithm::A_STAR) {
+    const geo::PreparedCoordinates target = stop_coordinates_.at(to);
+    route_info = router_->BuildRouteAStar(from, to, [this, &target](graph::VertexId vertex) {
+      return minutes_per_meter_ * geo::ComputeDistance(stop_coordinates_[vertex], target);
+    }, stats);
+  } else if (router_ && stats) {
+    // Тот же поиск между двумя вершинами без оценки, чтобы статистика была сравнима с A*
+    route_info = router_->BuildRouteAStar(from, to, graph::ZeroHeuristic<double>{}, stats);
+  } else if (all_pairs_router_) {
+    route_info = all_pairs_router_->BuildRoute(from, to);
+  } else if (compact_all_pairs_router_) {
+    route_info = compact_all_pairs_router_->BuildRoute(from, to);
+  } else if (contraction_hierarchy_) {
+    route_info = contraction_hierarchy_->BuildRoute(from, to, stats);
+  } else {
+    route_info = router_->BuildRoute(from, to);
+  }
+  if (!route_info) {
+    return std::nullopt;
+  }
+  return MakeRoute(*route_info);
+}
 
-      // не круговой
-    else {
-      AddDirectBusToGraph(result, bus);
+std::vector<TransportRouter::Route> TransportRouter::BuildParetoRoutes(graph::VertexId from, graph::VertexId to,
+                                                                      std::optional<size_t> max_transfers) const {
+  std::vector<Route> result;
+  if (raptor_router_) {
+    for (auto &journey: raptor_router_->BuildRoutesByLegs(
+        from, to, max_transfers ? *max_transfers + 1 : raptor::Router::NO_LEGS_LIMIT)) {
+      result.push_back({journey.total_time, std::move(journey.legs)});
     }
+    return result;
+  }
+  // Поездка - одно ребро графа, поэтому число рёбер на единицу больше числа пересадок
+  for (const auto &route_info: pareto_router_.BuildRoutes(
+      from, to, max_transfers ? *max_transfers + 1 : graph::ParetoRouter<double>::NO_EDGES_LIMIT)) {
+    result.push_back(MakeRoute(route_info));
   }
   return result;
 }
 
-void TransportRouter::AddRoundtripBusToGtaph(graph::DirectedWeightedGraph<double> &result,
-                                             const transport_catalogue::Bus &bus) {
-  const auto curr_stops = bus.stops;
-  for (int count_first = 0; count_first < curr_stops.size() - 1; count_first++) {
-    for (int count_second = 1 + count_first; count_second <= curr_stops.size() - 1; count_second++) {
-      double total_dist = 0;
-      if (count_second - count_first == 1) {
-        total_dist = catalogue_.GetDistance(curr_stops[count_first], curr_stops[count_second]);
-      } else {
-        std::vector<transport_catalogue::Stop *> temp_cont = {curr_stops.begin() + count_first,
-                                                              curr_stops.begin() + count_second + 1};
-        for (auto it = temp_cont.begin(); it != temp_cont.end() - 1; it++) {
-          total_dist += catalogue_.GetDistance(*it, *(it + 1));
+std::vector<std::pair<graph::VertexId, double>> TransportRouter::BuildIsochrone(graph::VertexId from,
+                                                                               double max_time) const {
+  // Таблицы ALL_PAIRS и иерархия не дают ограниченного поиска, а граф есть во всех режимах, кроме RAPTOR
+  auto result = raptor_router_ ? raptor_router_->BuildReachable(from, max_time)
+                               : graph::BuildReachableVertices(graph_, from, max_time);
+  std::sort(result.begin(), result.end(), [](const auto &lhs, const auto &rhs) {
+    return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+  });
+  return result;
+}
+
+TransportRouter::Route TransportRouter::MakeRoute(const graph::Router<double>::RouteInfo &route_info) const {
+  Route result{route_info.weight, {}};
+  result.legs.reserve(route_info.edges.size());
+  for (const graph::EdgeId edge_id: route_info.edges) {
+    result.legs.push_back(graph_.GetEdge(edge_id));
+  }
+  return result;
+}
+
+TransportRouter::RouteMatrix TransportRouter::BuildRouteMatrix(const std::vector<graph::VertexId> &from,
+                                                              const std::vector<graph::VertexId> &to) const {
+  if (contraction_hierarchy_) {
+    return contraction_hierarchy_->BuildWeightsMatrix(from, to, settings_.matrix_threads);
+  }
+  RouteMatrix result(from.size());
+  // Строки независимы: для каждого источника - один поиск до всех целей сразу
+  parallel::ForEachIndex(from.size(), settings_.matrix_threads, [this, &from, &to, &result](size_t index) {
+    if (all_pairs_router_ || compact_all_pairs_router_) {
+      result[index].reserve(to.size());
+      for (const graph::VertexId target: to) {
+        result[index].push_back(all_pairs_router_ ? all_pairs_router_->GetRouteWeight(from[index], target)
+                                                  : compact_all_pairs_router_->GetRouteWeight(from[index], target));
+      }
+    } else if (raptor_router_) {
+      result[index] = raptor_router_->BuildWeights(from[index], to);
+    } else {
+      result[index] = router_->BuildWeights(from[index], to);
+    }
+  });
+  return result;
+}
+
+graph::DirectedWeightedGraph<double> TransportRouter::BuildGraph() {
+  if (settings_.algorithm == RoutingAlgorithm::RAPTOR) {
+    // RAPTOR работает с последовательностями остановок, квадратичное число рёбер не нужно
+    return graph::DirectedWeightedGraph<double>(catalogue_.GetStopsCount());
+  }
+  const auto &curr_buses = catalogue_.GetBusesDequeConst();
+  std::vector<std::vector<graph::Edge<double>>> bus_edges(curr_buses.size());
+
+  // Маршруты независимы: потоки разбирают их по одному, а рёбра каждого
+  // маршрута пишутся в собственный буфер
+  parallel::ForEachIndex(curr_buses.size(), settings_.build_threads, [this, &bus_edges](size_t bus_id) {
+    bus_edges[bus_id] = BuildBusEdges(bus_id);
+  });
+
+  // Сливаем буферы в порядке маршрутов, чтобы идентификаторы рёбер не зависели от числа потоков
+  graph::GraphBuilder<double> result(catalogue_.GetStopsCount());
+  for (const auto &edges: bus_edges) {
+    for (const auto &edge: edges) {
+      result.AddEdge(edge);
+    }
+  }
+  return result.Build();
+}
+
+std::vector<graph::Edge<double>> TransportRouter::BuildBusEdges(size_t bus_id) const {
+  const auto &bus = catalogue_.GetBusFromId(bus_id);
+  std::vector<graph::Edge<double>> result;
+  // круговой маршрут
+  if (bus.is_roundtrip) {
+    AddRoundtripBusToGtaph(result, bus, static_cast<uint32_t>(bus_id));
+  }
+    // не круговой
+  else {
+    AddDirectBusToGraph(result, bus, static_cast<uint32_t>(bus_id));
+  }
+  return result;
+}
+
+void TransportRouter::AddBusPatterns(std::vector<raptor::Pattern> &result, size_t bus_id) const {
+  const auto &bus = catalogue_.GetBusFromId(bus_id);
+  if (bus.stops.empty()) {
+    return;
+  }
+  if (bus.is_roundtrip) {
+    result.push_back({static_cast<uint32_t>(bus_id), GetStopIds(bus, bus.stops.size()),
+                      ComputeCumulativeDistances(bus, bus.stops.size(), false)});
+    return;
+  }
+  // Как и в графе, поездка не проходит через конечную: половины маршрута независимы
+  const size_t half_count = bus.stops.size() / 2 + 1;
+  auto stop_ids = GetStopIds(bus, half_count);
+  const auto backward_distances = ComputeCumulativeDistances(bus, half_count, true);
+  raptor::Pattern backward{static_cast<uint32_t>(bus_id), {stop_ids.rbegin(), stop_ids.rend()}, {}};
+  backward.distances.reserve(half_count);
+  for (size_t index = half_count; index > 0; --index) {
+    backward.distances.push_back(backward_distances.back() - backward_distances[index - 1]);
+  }
+  result.push_back({static_cast<uint32_t>(bus_id), std::move(stop_ids),
+                    ComputeCumulativeDistances(bus, half_count, false)});
+  result.push_back(std::move(backward));
+}
+
+void TransportRouter::UpdateBus(size_t bus_id) {
+  ++version_;
+  if (bus_id < is_bus_removed_.size()) {
+    is_bus_removed_[bus_id] = false;
+  }
+  if (raptor_router_) {
+    InitializeRaptorRouter();
+    return;
+  }
+  std::vector<std::pair<size_t, std::vector<graph::Edge<double>>>> updates;
+  updates.emplace_back(bus_id, BuildBusEdges(bus_id));
+  ReplaceBusesEdges(std::move(updates));
+}
+
+void TransportRouter::RemoveBus(size_t bus_id) {
+  ++version_;
+  if (bus_id >= is_bus_removed_.size()) {
+    is_bus_removed_.resize(bus_id + 1, false);
+  }
+  is_bus_removed_[bus_id] = true;
+  if (raptor_router_) {
+    InitializeRaptorRouter();
+    return;
+  }
+  std::vector<std::pair<size_t, std::vector<graph::Edge<double>>>> updates;
+  updates.emplace_back(bus_id, std::vector<graph::Edge<double>>{});
+  ReplaceBusesEdges(std::move(updates));
+}
+
+void TransportRouter::UpdateDistance(graph::VertexId from, graph::VertexId to) {
+  ++version_;
+  if (raptor_router_) {
+    InitializeRaptorRouter();
+    return;
+  }
+  std::vector<std::pair<size_t, std::vector<graph::Edge<double>>>> updates;
+  const auto &buses = catalogue_.GetBusesDequeConst();
+  for (size_t bus_id = 0; bus_id < buses.size(); ++bus_id) {
+    // Удалённые маршруты не восстанавливаются
+    if (bus_id < is_bus_removed_.size() && is_bus_removed_[bus_id]) {
+      continue;
+    }
+    const auto &stops = buses[bus_id].stops;
+    for (size_t index = 0; index + 1 < stops.size(); ++index) {
+      const graph::VertexId first = stops[index]->id;
+      const graph::VertexId second = stops[index + 1]->id;
+      if ((first == from && second == to) || (first == to && second == from)) {
+        updates.emplace_back(bus_id, BuildBusEdges(bus_id));
+        break;
+      }
+    }
+  }
+  if (!updates.empty()) {
+    ReplaceBusesEdges(std::move(updates));
+  }
+}
+
+void TransportRouter::InitializeBusEdgeIds() {
+  if (are_bus_edge_ids_initialized_) {
+    return;
+  }
+  // Рёбра маршрута перечисляются по возрастанию идентификаторов: по начальной вершине,
+  // а у одной вершины - в порядке построения маршрута
+  bus_edge_ids_.assign(catalogue_.GetBusesDequeConst().size(), {});
+  for (graph::VertexId vertex = 0; vertex < graph_.GetVertexCount(); ++vertex) {
+    for (const graph::EdgeId edge_id: graph_.GetIncidentEdges(vertex)) {
+      bus_edge_ids_.at(graph_.GetEdge(edge_id).bus_id).push_back(edge_id);
+    }
+  }
+  are_bus_edge_ids_initialized_ = true;
+}
+
+void TransportRouter::ReplaceBusesEdges(std::vector<std::pair<size_t, std::vector<graph::Edge<double>>>> updates) {
+  if (catalogue_.GetStopsCount() != graph_.GetVertexCount()) {
+    throw std::logic_error("Stops were added to the catalogue, the router must be rebuilt");
+  }
+  InitializeBusEdgeIds();
+
+  graph::GraphChanges changes;
+  // Старые идентификаторы рёбер, вес которых уменьшился без изменения состава маршрута
+  std::vector<graph::EdgeId> improved_edges;
+  // Маршруты с другим набором рёбер: их старые рёбра удаляются, новые добавляются
+  std::vector<std::pair<size_t, size_t>> reshaped_buses;
+  std::vector<graph::EdgeId> removed_edges;
+  std::vector<graph::Edge<double>> added_edges;
+  std::vector<bool> is_updated(catalogue_.GetBusesDequeConst().size(), false);
+  for (auto &[bus_id, edges]: updates) {
+    if (is_updated.at(bus_id)) {
+      continue;
+    }
+    is_updated[bus_id] = true;
+    if (bus_id >= bus_edge_ids_.size()) {
+      bus_edge_ids_.resize(bus_id + 1);
+    }
+    // Тот же порядок, в котором идут идентификаторы рёбер маршрута в графе
+    std::stable_sort(edges.begin(), edges.end(), [](const auto &lhs, const auto &rhs) {
+      return lhs.from < rhs.from;
+    });
+    auto &edge_ids = bus_edge_ids_[bus_id];
+    const bool is_same_shape = edge_ids.size() == edges.size()
+                               && std::equal(edge_ids.begin(), edge_ids.end(), edges.begin(),
+                                             [this](graph::EdgeId edge_id, const auto &edge) {
+                                               const auto old_edge = graph_.GetEdge(edge_id);
+                                               return old_edge.from == edge.from && old_edge.to == edge.to
+                                                      && old_edge.span_count == edge.span_count;
+                                             });
+    if (is_same_shape) {
+      // Меняются только веса, идентификаторы рёбер сохраняются
+      for (size_t index = 0; index < edges.size(); ++index) {
+        const graph::EdgeId edge_id = edge_ids[index];
+        const double old_weight = graph_.GetEdgeWeight(edge_id);
+        if (old_weight < edges[index].weight) {
+          changes.worsened_edges.push_back(edge_id);
+        } else if (edges[index].weight < old_weight) {
+          improved_edges.push_back(edge_id);
         }
+        graph_.SetEdgeWeight(edge_id, edges[index].weight);
+      }
+      continue;
+    }
+    removed_edges.insert(removed_edges.end(), edge_ids.begin(), edge_ids.end());
+    changes.worsened_edges.insert(changes.worsened_edges.end(), edge_ids.begin(), edge_ids.end());
+    edge_ids.clear();
+    reshaped_buses.emplace_back(bus_id, edges.size());
+    added_edges.insert(added_edges.end(), edges.begin(), edges.end());
+  }
+
+  if (reshaped_buses.empty()) {
+    changes.new_edge_ids.resize(graph_.GetEdgeCount());
+    std::iota(changes.new_edge_ids.begin(), changes.new_edge_ids.end(), graph::EdgeId{0});
+    changes.improved_edges = std::move(improved_edges);
+  } else {
+    // Граф правится на месте, чтобы ссылки на него из алгоритмов оставались действительными.
+    // Оставшиеся рёбра сохраняют взаимный порядок, поэтому списки маршрутов остаются упорядоченными.
+    std::vector<graph::EdgeId> added_edge_ids;
+    changes.new_edge_ids = graph_.ReplaceEdges(removed_edges, added_edges, &added_edge_ids);
+    for (auto &edge_ids: bus_edge_ids_) {
+      for (graph::EdgeId &edge_id: edge_ids) {
+        edge_id = changes.new_edge_ids[edge_id];
       }
-      result.AddEdge({catalogue_.GetStopId(curr_stops[count_first]->name),
-                      catalogue_.GetStopId(curr_stops[count_second]->name),
-                      wait_time_ + total_dist / speed_ * 1.0,
-                      bus.name,
-                      std::abs(count_second - count_first)});
+    }
+    for (const graph::EdgeId edge_id: improved_edges) {
+      changes.improved_edges.push_back(changes.new_edge_ids[edge_id]);
+    }
+    auto added_id_it = added_edge_ids.begin();
+    for (const auto &[bus_id, edges_count]: reshaped_buses) {
+      const auto added_id_end = added_id_it + static_cast<std::ptrdiff_t>(edges_count);
+      bus_edge_ids_[bus_id].assign(added_id_it, added_id_end);
+      changes.improved_edges.insert(changes.improved_edges.end(), added_id_it, added_id_end);
+      added_id_it = added_id_end;
+    }
+  }
+
+  if (router_) {
+    router_->ApplyGraphChanges(changes);
+  }
+  if (settings_.algorithm == RoutingAlgorithm::A_STAR) {
+    // Удаление рёбер оставляет оценку допустимой, новые рёбра могут её только уменьшить
+    for (const graph::EdgeId edge_id: changes.improved_edges) {
+      const double distance = geo::ComputeDistance(stop_coordinates_[graph_.GetEdgeSource(edge_id)],
+                                                   stop_coordinates_[graph_.GetEdgeTarget(edge_id)]);
+      if (distance > 0) {
+        minutes_per_meter_ = std::min(minutes_per_meter_, graph_.GetEdgeWeight(edge_id) / distance);
+      }
+    }
+  }
+  // Таблицы всех пар и иерархия сжатий - глобальные предвычисления, их приходится строить заново
+  if (all_pairs_router_ || compact_all_pairs_router_ || contraction_hierarchy_) {
+    all_pairs_router_.reset();
+    compact_all_pairs_router_.reset();
+    contraction_hierarchy_.reset();
+    Data data;
+    InitializeRouter(data);
+  }
+}
+
+std::vector<graph::VertexId> TransportRouter::GetStopIds(const transport_catalogue::Bus &bus, size_t count) const {
+  std::vector<graph::VertexId> result;
+  result.reserve(count);
+  for (size_t index = 0; index < count; ++index) {
+    result.push_back(bus.stops[index]->id);
+  }
+  return result;
+}
+
+std::vector<int64_t> TransportRouter::ComputeCumulativeDistances(const transport_catalogue::Bus &bus, size_t count,
+                                                                 bool backward) const {
+  // result[k] - суммарная длина участков между остановками 0..k,
+  // при backward каждый участок проезжается в обратную сторону
+  std::vector<int64_t> result(count, 0);
+  for (size_t index = 1; index < count; ++index) {
+    const auto from = bus.stops[backward ? index : index - 1];
+    const auto to = bus.stops[backward ? index - 1 : index];
+    result[index] = result[index - 1] + catalogue_.GetDistance(from, to);
+  }
+  return result;
+}
+
+void TransportRouter::AddRoundtripBusToGtaph(std::vector<graph::Edge<double>> &result,
+                                             const transport_catalogue::Bus &bus, uint32_t bus_id) const {
+  const size_t stops_count = bus.stops.size();
+  const auto stop_ids = GetStopIds(bus, stops_count);
+  const auto distances = ComputeCumulativeDistances(bus, stops_count, false);
+  result.reserve(stops_count * (stops_count - std::min<size_t>(stops_count, 1)) / 2);
+  for (size_t count_first = 0; count_first + 1 < stops_count; count_first++) {
+    for (size_t count_second = count_first + 1; count_second < stops_count; count_second++) {
+      const double total_dist = distances[count_second] - distances[count_first];
+      result.push_back({stop_ids[count_first],
+                      stop_ids[count_second],
+                      settings_.bus_wait_time + total_dist / settings_.bus_velocity * 1.0,
+                      bus_id,
+                      static_cast<int>(count_second - count_first)});
     }
   }
 }
 
-void TransportRouter::AddDirectBusToGraph(graph::DirectedWeightedGraph<double> &result,
-                                          const transport_catalogue::Bus &bus) {
-  const auto curr_stops = bus.stops;
-  for (int count_first = 0; count_first <= curr_stops.size() / 2; count_first++) {
-    for (int count_second = 0; count_second <= curr_stops.size() / 2; count_second++) {
+void TransportRouter::AddDirectBusToGraph(std::vector<graph::Edge<double>> &result,
+                                          const transport_catalogue::Bus &bus, uint32_t bus_id) const {
+  if (bus.stops.empty()) {
+    return;
+  }
+  // Вторая половина некругового маршрута повторяет первую в обратном порядке
+  const size_t half_count = bus.stops.size() / 2 + 1;
+  const auto stop_ids = GetStopIds(bus, half_count);
+  const auto forward_distances = ComputeCumulativeDistances(bus, half_count, false);
+  const auto backward_distances = ComputeCumulativeDistances(bus, half_count, true);
+  result.reserve(half_count * half_count);
+  for (size_t count_first = 0; count_first < half_count; count_first++) {
+    for (size_t count_second = 0; count_second < half_count; count_second++) {
       double total_dist = 0;
-      if (std::abs(count_second - count_first) <= 1) {
-        total_dist = catalogue_.GetDistance(curr_stops[count_first], curr_stops[count_second]);
-      } else {
+      if (count_first == count_second) {
+        total_dist = catalogue_.GetDistance(bus.stops[count_first], bus.stops[count_second]);
+      } else if (count_first > count_second) {
         // отдельно рассматриваем случай поедки в обратном направлении
-        if (count_first > count_second) {
-          for (auto it = curr_stops.begin() + count_first; it > curr_stops.begin() + count_second; it--) {
-            total_dist += catalogue_.GetDistance(*it, *(it - 1));
-          }
-        } else {
-          std::vector<transport_catalogue::Stop *> temp_cont = {curr_stops.begin() + count_first,
-                                                                curr_stops.begin() + count_second + 1};
-          for (auto it = temp_cont.begin(); it != temp_cont.end() - 1; it++) {
-            total_dist += catalogue_.GetDistance(*it, *(it + 1));
-          }
-        }
+        total_dist = backward_distances[count_first] - backward_distances[count_second];
+      } else {
+        total_dist = forward_distances[count_second] - forward_distances[count_first];
       }
 
-      result.AddEdge({catalogue_.GetStopId(curr_stops[count_first]->name),
-                      catalogue_.GetStopId(curr_stops[count_second]->name),
-                      wait_time_ + total_dist / speed_ * 1.0,
-                      bus.name,
-                      std::abs(count_second - count_first)});
+      result.push_back({stop_ids[count_first],
+                      stop_ids[count_second],
+                      settings_.bus_wait_time + total_dist / settings_.bus_velocity * 1.0,
+                      bus_id,
+                      static_cast<int>(std::max(count_first, count_second) - std::min(count_first, count_second))});
     }
   }
-}
\ No newline at end of file
+}
@@ -6,36 +6,180 @@
 #include "numeric"
 #include "optional"
 #include "router.h"
+#include "all_pairs_router.h"
+#include "contraction_hierarchy.h"
+#include "pareto_router.h"
+#include "raptor.h"
+#include <memory>
 
 using namespace graph;
 
+enum class RoutingAlgorithm {
+  // Дейкстра из вершины-источника по запросу с кэшированием деревьев
+  DIJKSTRA,
+  // Полная таблица кратчайших путей, строится один раз при создании
+  ALL_PAIRS,
+  // Иерархия сжатий: предобработка при создании, быстрые точечные запросы
+  CONTRACTION_HIERARCHIES,
+  // A* между двумя остановками с оценкой по расстоянию на сфере
+  A_STAR,
+  // Поиск по раундам прямо по маршрутам, без графа со всеми парами остановок маршрута
+  RAPTOR,
+};
+
+// Тип весов в таблице ALL_PAIRS
+enum class AllPairsPrecision {
+  DOUBLE,
+  // Вдвое меньше памяти, маршрут оптимален с относительной точностью float
+  FLOAT,
+};
+
+struct RoutingSettings {
+  double bus_wait_time = 0;
+  // Скорость в метрах в минуту
+  double bus_velocity = 1;
+  RoutingAlgorithm algorithm = RoutingAlgorithm::DIJKSTRA;
+  // Число потоков для построения графа, 0 - по числу ядер
+  size_t build_threads = 0;
+  // Число потоков для расчёта матрицы маршрутов, 0 - по числу ядер
+  size_t matrix_threads = 0;
+  AllPairsPrecision all_pairs_precision = AllPairsPrecision::DOUBLE;
+};
+
 class TransportRouter {
 
 public:
-  TransportRouter(const transport_catalogue::TransportCatalogue &catalogue, double speed, double wait_time)
-      : catalogue_(catalogue), speed_(speed), wait_time_(wait_time) {
-    graph_ = BuildGraph();
+  // Поездки маршрута по порядку: ожидание на остановке from и проезд до to
+  struct Route {
+    double total_time;
+    std::vector<graph::Edge<double>> legs;
+  };
+  // Строка на каждый источник, столбец на каждую цель, nullopt - цель недостижима
+  using RouteMatrix = std::vector<std::vector<std::optional<double>>>;
+
+  // Всё, что строится при создании роутера: граф и таблицы выбранного алгоритма.
+  // Для RAPTOR граф пуст, последовательности остановок восстанавливаются из справочника.
+  struct Data {
+    graph::DirectedWeightedGraph<double>::Arrays graph;
+    std::optional<graph::AllPairsRouter<double>::Data> all_pairs;
+    std::optional<graph::AllPairsRouter<double, float>::Data> compact_all_pairs;
+    std::optional<graph::ContractionHierarchy<double>::Data> contraction_hierarchy;
+  };
+
+  TransportRouter(const transport_catalogue::TransportCatalogue &catalogue, const RoutingSettings &settings);
+
+  // Восстанавливает роутер из ранее построенных данных. Недостающие таблицы строятся заново.
+  TransportRouter(const transport_catalogue::TransportCatalogue &catalogue, const RoutingSettings &settings,
+                  Data data);
+
+  // Граф хранится внутри роутера, а алгоритмы маршрутизации ссылаются на него,
+  // поэтому копия или перемещённый объект ссылались бы на чужой граф
+  TransportRouter(const TransportRouter &) = delete;
+  TransportRouter &operator=(const TransportRouter &) = delete;
+  TransportRouter(TransportRouter &&) = delete;
+  TransportRouter &operator=(TransportRouter &&) = delete;
+
+  const RoutingSettings &GetSettings() const {
+    return settings_;
   }
 
-  const graph::DirectedWeightedGraph<double> &GetGraph() {
+  Data GetData() const;
+
+  // Увеличивается при каждом инкрементальном изменении маршрутов
+  uint64_t GetVersion() const {
+    return version_;
+  }
+
+  const graph::DirectedWeightedGraph<double> &GetGraph() const {
     return graph_;
   }
 
-  template<typename Weight>
-  std::optional<typename Router<Weight>::RouteInfo> GetRoute(graph::VertexId from, graph::VertexId to) const {
-    graph::Router<Weight> router(&graph_);
-    return router.BuildRoute(from, to);
+  // stats заполняется для поиска A*, Дейкстры (в этом случае кэш деревьев не используется)
+  // и иерархии сжатий, см. IsSearchStatsSupported
+  std::optional<Route> BuildRoute(graph::VertexId from, graph::VertexId to,
+                                  graph::SearchStats *stats = nullptr) const;
+
+  // Таблица всех пар отвечает без поиска, а RAPTOR просматривает не вершины графа, а рейсы,
+  // поэтому для них статистика поиска не собирается
+  bool IsSearchStatsSupported() const {
+    return !raptor_router_ && !all_pairs_router_ && !compact_all_pairs_router_;
   }
 
+  // Маршруты, оптимальные по Парето по времени и числу пересадок, с не более чем max_transfers
+  // пересадками: по возрастанию числа поездок, каждый следующий быстрее предыдущего
+  std::vector<Route> BuildParetoRoutes(graph::VertexId from, graph::VertexId to,
+                                       std::optional<size_t> max_transfers = std::nullopt) const;
+
+  // Остановки, до которых можно доехать из from не более чем за max_time, и время в пути до них.
+  // Один ограниченный поиск из from, результат упорядочен по времени, затем по номеру остановки.
+  std::vector<std::pair<graph::VertexId, double>> BuildIsochrone(graph::VertexId from, double max_time) const;
+
+  // Время в пути между всеми парами from x to без восстановления маршрутов
+  RouteMatrix BuildRouteMatrix(const std::vector<graph::VertexId> &from, const std::vector<graph::VertexId> &to) const;
+
+  // Инкрементальные изменения: рёбра затронутых маршрутов пересчитываются по текущему
+  // состоянию справочника, а кэшированные деревья поиска исправляются, а не строятся заново.
+  // Таблицы ALL_PAIRS и CONTRACTION_HIERARCHIES и маршруты RAPTOR перестраиваются целиком.
+  // Изменения нельзя выполнять одновременно с запросами маршрутов.
+
+  // Маршрут изменён или только что добавлен в справочник
+  void UpdateBus(size_t bus_id);
+
+  // Рёбра маршрута убираются из графа, сам маршрут в справочнике остаётся
+  void RemoveBus(size_t bus_id);
+
+  // Расстояние между остановками изменено через SetDistance: пересчитываются маршруты с этим участком
+  void UpdateDistance(graph::VertexId from, graph::VertexId to);
+
 private:
   graph::DirectedWeightedGraph<double> BuildGraph();
 
-  void AddRoundtripBusToGtaph(graph::DirectedWeightedGraph<double> &result, const transport_catalogue::Bus &bus);
+  void InitializeRouter(Data &data);
+
+  void InitializeAStarHeuristic();
+
+  std::vector<graph::Edge<double>> BuildBusEdges(size_t bus_id) const;
+
+  // Некруговой маршрут даёт две последовательности: туда и обратно до разворота
+  void AddBusPatterns(std::vector<raptor::Pattern> &result, size_t bus_id) const;
+
+  void InitializeRaptorRouter();
+
+  Route MakeRoute(const graph::Router<double>::RouteInfo &route_info) const;
+
+  void InitializeBusEdgeIds();
+
+  // Заменяет рёбра перечисленных маршрутов правкой графа на месте и сообщает об изменениях
+  // алгоритму маршрутизации
+  void ReplaceBusesEdges(std::vector<std::pair<size_t, std::vector<graph::Edge<double>>>> updates);
+
+  std::vector<graph::VertexId> GetStopIds(const transport_catalogue::Bus &bus, size_t count) const;
+
+  std::vector<int64_t> ComputeCumulativeDistances(const transport_catalogue::Bus &bus, size_t count,
+                                                  bool backward) const;
+
+  void AddRoundtripBusToGtaph(std::vector<graph::Edge<double>> &result, const transport_catalogue::Bus &bus,
+                              uint32_t bus_id) const;
 
-  void AddDirectBusToGraph(graph::DirectedWeightedGraph<double> &result, const transport_catalogue::Bus &bus);
+  void AddDirectBusToGraph(std::vector<graph::Edge<double>> &result, const transport_catalogue::Bus &bus,
+                           uint32_t bus_id) const;
 
   const transport_catalogue::TransportCatalogue &catalogue_;
-  double speed_;
-  double wait_time_;
+  RoutingSettings settings_;
   graph::DirectedWeightedGraph<double> graph_;
+  graph::ParetoRouter<double> pareto_router_{graph_};
+  std::unique_ptr<graph::Router<double>> router_;
+  std::unique_ptr<graph::AllPairsRouter<double>> all_pairs_router_;
+  std::unique_ptr<graph::AllPairsRouter<double, float>> compact_all_pairs_router_;
+  std::unique_ptr<graph::ContractionHierarchy<double>> contraction_hierarchy_;
+  std::unique_ptr<raptor::Router> raptor_router_;
+  // Маршруты, убранные через RemoveBus
+  std::vector<bool> is_bus_removed_;
+  uint64_t version_ = 0;
+  // Координаты остановок по номеру вершины и нижняя оценка времени на метр для A*
+  std::vector<geo::PreparedCoordinates> stop_coordinates_;
+  double minutes_per_meter_ = 0;
+  // Идентификаторы рёбер каждого маршрута в текущем графе по возрастанию, заполняются при первом изменении
+  std::vector<std::vector<graph::EdgeId>> bus_edge_ids_;
+  bool are_bus_edge_ids_initialized_ = false;
 };
\ No newline at end of file